@@ -6,6 +6,7 @@
 #include <wn.h>
 
 #include "json_extract.h"
+#include "word_cache.h"
 
 #define MAX_TERM 64
 #define MAX_LIST 128
@@ -14,6 +15,8 @@
 #define MAX_CONCEPTS 16
 #define MAX_TERMS 1024
 #define MAX_GLOSS 512
+#define MEMO_BUCKETS 4096
+#define MEMO_MAX 16384
 
 struct concept {
     const char *name;
@@ -21,7 +24,6 @@ struct concept {
     const char *seeds[16];
     char terms[MAX_CONCEPT_TERMS][MAX_TERM];
     int term_count;
-    int score;
 };
 
 struct chat_context {
@@ -82,6 +84,48 @@ struct analysis_result {
     int has_greeting;
 };
 
+/* Word cache written by wn-cache, if one was loaded */
+static struct word_cache cache;
+
+/* What analyze_input() takes from the first sense of a word in one part
+ * of speech, kept for the rest of the session: its synonyms and the
+ * words of its hypernyms, normalized and without noise tokens, and its
+ * gloss.  The word, then these, are packed into text, each ending in
+ * '\0', at the offsets given. */
+struct sense_memo {
+    struct sense_memo *next;
+    int pos;
+    int found;
+    int synonyms;
+    int synonym_count;
+    int hypernyms;
+    int hypernym_count;
+    int gloss;                  /* -1 if there is none */
+    char text[];
+};
+
+static struct sense_memo *memo_buckets[MEMO_BUCKETS];
+static int memo_count;
+
+/* Concepts a request is ranked against, with the terms their seeds
+ * expand to */
+static struct concept concepts[] = {
+    { "requirements", "sdlc", { "requirement", "specification", "story", "scope", NULL }, { { 0 } }, 0 },
+    { "design", "sdlc", { "design", "architecture", "model", "interface", NULL }, { { 0 } }, 0 },
+    { "implementation", "sdlc", { "implement", "build", "code", "develop", NULL }, { { 0 } }, 0 },
+    { "testing", "sdlc", { "test", "verify", "validate", "qa", NULL }, { { 0 } }, 0 },
+    { "deployment", "sdlc", { "deploy", "release", "ship", "deliver", NULL }, { { 0 } }, 0 },
+    { "maintenance", "sdlc", { "maintain", "operate", "support", "monitor", NULL }, { { 0 } }, 0 },
+    { "api", "design", { "api", "interface", "endpoint", "protocol", NULL }, { { 0 } }, 0 },
+    { "data", "design", { "data", "database", "storage", "schema", NULL }, { { 0 } }, 0 },
+    { "ui", "design", { "ui", "ux", "screen", "visual", NULL }, { { 0 } }, 0 },
+    { "performance", "design", { "performance", "latency", "throughput", "optimize", NULL }, { { 0 } }, 0 },
+    { "security", "design", { "security", "auth", "encrypt", "permission", NULL }, { { 0 } }, 0 },
+    { "reliability", "design", { "reliability", "retry", "failover", "resilience", NULL }, { { 0 } }, 0 },
+    { "observability", "design", { "log", "trace", "monitor", "metric", NULL }, { { 0 } }, 0 }
+};
+static const int concept_count = (int)(sizeof(concepts) / sizeof(concepts[0]));
+
 static int is_noise_token(const char *word);
 
 static const char *stopwords[] = {
@@ -253,36 +297,12 @@ static int add_concept_term(struct concept *concept, const char *term)
     return add_unique(concept->terms, &concept->term_count, MAX_CONCEPT_TERMS, buf);
 }
 
-static void collect_from_synset(struct concept *concept, SynsetPtr syn)
-{
-    int i;
-
-    if (syn == NULL) {
-        return;
-    }
-    for (i = 0; i < syn->wcount; i++) {
-        add_concept_term(concept, syn->words[i]);
-    }
-}
-
-static void collect_memory_from_synset(struct chat_context *ctx, SynsetPtr syn)
+static void collect_from_sense(struct concept *concept, const struct word_sense *sense)
 {
     int i;
 
-    if (syn == NULL) {
-        return;
-    }
-    for (i = 0; i < syn->wcount; i++) {
-        char term[MAX_TERM];
-
-        snprintf(term, sizeof(term), "%s", syn->words[i]);
-        normalize_word(term);
-        if (!is_noise_token(term)) {
-            add_term_count(ctx, term, 2);
-        }
-    }
-    if (syn->defn != NULL) {
-        add_terms_from_text(ctx, syn->defn);
+    for (i = 0; i < word_sense_count(sense, -1); i++) {
+        add_concept_term(concept, word_sense_word(sense, -1, i));
     }
 }
 
@@ -301,51 +321,25 @@ static void expand_seed_terms(struct concept *concept)
         add_concept_term(concept, normalized);
 
         for (p = 0; p < 2; p++) {
-            int pos = pos_list[p];
-            IndexPtr idx = getindex(normalized, pos);
-            SynsetPtr syn;
+            struct word_sense sense;
 
-            if (idx == NULL || idx->off_cnt == 0) {
-                if (idx != NULL) {
-                    free_index(idx);
-                }
-                continue;
+            if (word_sense_lookup(&cache, normalized, pos_list[p], &sense)) {
+                collect_from_sense(concept, &sense);
+                word_sense_free(&sense);
             }
-            syn = read_synset(pos, idx->offset[0], normalized);
-            if (syn != NULL) {
-                collect_from_synset(concept, syn);
-                free_synset(syn);
-            }
-            free_index(idx);
         }
     }
 }
 
-static void init_concepts(struct concept *concepts, int *concept_count)
+/* Expand the seeds of every concept into their synonyms.  This is done
+ * once, at startup, and the concepts are only read after that. */
+static void init_concepts(void)
 {
-    struct concept base[] = {
-        { "requirements", "sdlc", { "requirement", "specification", "story", "scope", NULL }, { { 0 } }, 0, 0 },
-        { "design", "sdlc", { "design", "architecture", "model", "interface", NULL }, { { 0 } }, 0, 0 },
-        { "implementation", "sdlc", { "implement", "build", "code", "develop", NULL }, { { 0 } }, 0, 0 },
-        { "testing", "sdlc", { "test", "verify", "validate", "qa", NULL }, { { 0 } }, 0, 0 },
-        { "deployment", "sdlc", { "deploy", "release", "ship", "deliver", NULL }, { { 0 } }, 0, 0 },
-        { "maintenance", "sdlc", { "maintain", "operate", "support", "monitor", NULL }, { { 0 } }, 0, 0 },
-        { "api", "design", { "api", "interface", "endpoint", "protocol", NULL }, { { 0 } }, 0, 0 },
-        { "data", "design", { "data", "database", "storage", "schema", NULL }, { { 0 } }, 0, 0 },
-        { "ui", "design", { "ui", "ux", "screen", "visual", NULL }, { { 0 } }, 0, 0 },
-        { "performance", "design", { "performance", "latency", "throughput", "optimize", NULL }, { { 0 } }, 0, 0 },
-        { "security", "design", { "security", "auth", "encrypt", "permission", NULL }, { { 0 } }, 0, 0 },
-        { "reliability", "design", { "reliability", "retry", "failover", "resilience", NULL }, { { 0 } }, 0, 0 },
-        { "observability", "design", { "log", "trace", "monitor", "metric", NULL }, { { 0 } }, 0, 0 }
-    };
     int i;
-    int count = (int)(sizeof(base) / sizeof(base[0]));
 
-    for (i = 0; i < count; i++) {
-        concepts[i] = base[i];
+    for (i = 0; i < concept_count; i++) {
         expand_seed_terms(&concepts[i]);
     }
-    *concept_count = count;
 }
 
 static int is_generic_verb(const char *word)
@@ -380,7 +374,7 @@ static int is_allowed_action(const char *word)
     return 0;
 }
 
-static int token_matches(const char *token, struct concept *concept)
+static int token_matches(const char *token, const struct concept *concept)
 {
     int i;
 
@@ -559,32 +553,18 @@ static int sentence_has_verb(const char *text)
                 token[j++] = (char)tolower(c);
             }
         } else if (j > 0) {
-            IndexPtr idx;
-
             token[j] = '\0';
             j = 0;
-            idx = getindex(token, VERB);
-            if (idx != NULL && idx->off_cnt > 0) {
-                free_index(idx);
+            if (word_cache_contains(&cache, token, VERB)) {
                 return 1;
             }
-            if (idx != NULL) {
-                free_index(idx);
-            }
         }
     }
     if (j > 0) {
-        IndexPtr idx;
-
         token[j] = '\0';
-        idx = getindex(token, VERB);
-        if (idx != NULL && idx->off_cnt > 0) {
-            free_index(idx);
+        if (word_cache_contains(&cache, token, VERB)) {
             return 1;
         }
-        if (idx != NULL) {
-            free_index(idx);
-        }
     }
     return 0;
 }
@@ -1102,7 +1082,8 @@ static void synthesize_response(struct chat_context *ctx, struct analysis_result
     apply_guardrails(out, out_size);
 }
 
-static void rank_concepts(struct concept *concepts, int concept_count,
+/* Score each concept for this turn into scores */
+static void rank_concepts(int *scores,
                           char list[][MAX_TERM], int list_count,
                           struct chat_context *ctx,
                           struct analysis_result *analysis)
@@ -1111,14 +1092,14 @@ static void rank_concepts(struct concept *concepts, int concept_count,
     int j;
 
     for (i = 0; i < concept_count; i++) {
-        concepts[i].score = 0;
+        scores[i] = 0;
     }
     for (i = 0; i < list_count; i++) {
         for (j = 0; j < concept_count; j++) {
             if (token_matches(list[i], &concepts[j])) {
                 int freq = term_frequency(ctx, list[i]);
                 int boost = freq > 4 ? 2 : (freq > 0 ? 1 : 0);
-                concepts[j].score += 2 + boost;
+                scores[j] += 2 + boost;
             }
         }
     }
@@ -1127,7 +1108,7 @@ static void rank_concepts(struct concept *concepts, int concept_count,
         for (k = 0; k < concepts[j].term_count; k++) {
             int rel_score = related_match_score(analysis, concepts[j].terms[k]);
             if (rel_score > 0) {
-                concepts[j].score += rel_score;
+                scores[j] += rel_score;
             }
         }
     }
@@ -1266,57 +1247,174 @@ static struct related_term *find_or_add_related(struct analysis_result *analysis
     return &analysis->related[analysis->related_count++];
 }
 
-static void fetch_related_terms(const char *term, int pos, SynsetPtr syn,
+static void free_sense_memos(void)
+{
+    int i;
+
+    for (i = 0; i < MEMO_BUCKETS; i++) {
+        while (memo_buckets[i] != NULL) {
+            struct sense_memo *next = memo_buckets[i]->next;
+            free(memo_buckets[i]);
+            memo_buckets[i] = next;
+        }
+    }
+    memo_count = 0;
+}
+
+/* Add the normalized words of synset h of sense that aren't noise
+ * tokens to text at *len, or only count their length if text is NULL.
+ * Returns the number of words. */
+static int pack_words(const struct word_sense *sense, int h, char *text, size_t *len)
+{
+    int count = 0;
+    int i;
+
+    for (i = 0; i < word_sense_count(sense, h); i++) {
+        char word[MAX_TERM];
+        size_t n;
+
+        snprintf(word, sizeof(word), "%s", word_sense_word(sense, h, i));
+        normalize_word(word);
+        if (is_noise_token(word)) {
+            continue;
+        }
+        n = strlen(word) + 1;
+        if (text != NULL) {
+            memcpy(text + *len, word, n);
+        }
+        *len += n;
+        count++;
+    }
+    return count;
+}
+
+/* Pack word and what's used of its sense into text, or only count the
+ * length if memo is NULL.  Returns the length. */
+static size_t pack_sense(const char *word, const struct word_sense *sense,
+                         const char *gloss, struct sense_memo *memo)
+{
+    char *text = memo != NULL ? memo->text : NULL;
+    size_t len = strlen(word) + 1;
+    int synonym_count;
+    int hypernym_count = 0;
+    int i;
+
+    if (text != NULL) {
+        memcpy(text, word, len);
+        memo->synonyms = (int)len;
+    }
+    synonym_count = pack_words(sense, -1, text, &len);
+    if (text != NULL) {
+        memo->synonym_count = synonym_count;
+        memo->hypernyms = (int)len;
+    }
+    for (i = 0; i < sense->hypernym_count; i++) {
+        hypernym_count += pack_words(sense, i, text, &len);
+    }
+    if (text != NULL) {
+        memo->hypernym_count = hypernym_count;
+        memo->gloss = gloss != NULL ? (int)len : -1;
+    }
+    if (gloss != NULL) {
+        if (text != NULL) {
+            memcpy(text + len, gloss, strlen(gloss) + 1);
+        }
+        len += strlen(gloss) + 1;
+    }
+    return len;
+}
+
+/* Return what analyze_input() needs of the first sense of word in pos,
+ * looking it up the first time it's asked for in the session. */
+static const struct sense_memo *lookup_sense_memo(const char *word, int pos)
+{
+    unsigned int h = 2166136261U;
+    const unsigned char *p;
+    struct sense_memo *memo;
+    struct word_sense sense;
+    char gloss[MAX_GLOSS];
+    const char *g = NULL;
+    int found;
+
+    for (p = (const unsigned char *)word; *p != '\0'; p++) {
+        h = (h ^ *p) * 16777619U;
+    }
+    h = (h ^ (unsigned int)pos) % MEMO_BUCKETS;
+    for (memo = memo_buckets[h]; memo != NULL; memo = memo->next) {
+        if (memo->pos == pos && strcmp(memo->text, word) == 0) {
+            return memo;
+        }
+    }
+
+    if (memo_count >= MEMO_MAX) {
+        free_sense_memos();
+    }
+    found = word_sense_lookup(&cache, word, pos, &sense);
+    if (found && word_sense_gloss(&sense, -1) != NULL) {
+        /* only this much of a gloss is ever used */
+        snprintf(gloss, sizeof(gloss), "%s", word_sense_gloss(&sense, -1));
+        g = gloss;
+    }
+    memo = malloc(sizeof(*memo) + (found ? pack_sense(word, &sense, g, NULL)
+                                         : strlen(word) + 1));
+    if (memo == NULL) {
+        fprintf(stderr, "wn-chat: out of memory\n");
+        exit(1);
+    }
+    memo->pos = pos;
+    memo->found = found;
+    if (found) {
+        pack_sense(word, &sense, g, memo);
+        word_sense_free(&sense);
+    } else {
+        strcpy(memo->text, word);
+    }
+    memo->next = memo_buckets[h];
+    memo_buckets[h] = memo;
+    memo_count++;
+    return memo;
+}
+
+static void collect_memory_from_memo(struct chat_context *ctx, const struct sense_memo *memo)
+{
+    const char *word = memo->text + memo->synonyms;
+    int i;
+
+    for (i = 0; i < memo->synonym_count; i++, word += strlen(word) + 1) {
+        add_term_count(ctx, word, 2);
+    }
+    if (memo->gloss >= 0) {
+        add_terms_from_text(ctx, memo->text + memo->gloss);
+    }
+}
+
+static void fetch_related_terms(const char *term, int pos, const struct sense_memo *memo,
                                 struct analysis_result *analysis,
                                 struct chat_context *ctx)
 {
     int i;
     struct related_term *related = find_or_add_related(analysis, term);
+    const char *word;
 
-    if (related == NULL || syn == NULL) {
+    if (related == NULL) {
         return;
     }
-    for (i = 0; i < syn->wcount; i++) {
-        char synword[MAX_TERM];
-        snprintf(synword, sizeof(synword), "%s", syn->words[i]);
-        normalize_word(synword);
-        if (!is_noise_token(synword)) {
-            add_unique(related->synonyms, &related->synonym_count, MAX_LIST, synword);
-        }
+    word = memo->text + memo->synonyms;
+    for (i = 0; i < memo->synonym_count; i++, word += strlen(word) + 1) {
+        add_unique(related->synonyms, &related->synonym_count, MAX_LIST, word);
     }
-    if (syn->defn != NULL && related->gloss[0] == '\0') {
-        snprintf(related->gloss, sizeof(related->gloss), "%s", syn->defn);
+    if (memo->gloss >= 0 && related->gloss[0] == '\0') {
+        snprintf(related->gloss, sizeof(related->gloss), "%s", memo->text + memo->gloss);
     }
-    for (i = 0; i < syn->ptrcount; i++) {
-        if (syn->ptrtyp[i] != HYPERPTR) {
-            continue;
-        }
-        if (syn->ppos[i] == 0) {
-            continue;
-        }
-        {
-            char term_buf[MAX_TERM];
-            snprintf(term_buf, sizeof(term_buf), "%s", term);
-            SynsetPtr hyper = read_synset(syn->ppos[i], syn->ptroff[i], term_buf);
-            if (hyper != NULL) {
-                int w;
-                for (w = 0; w < hyper->wcount; w++) {
-                    char hyperword[MAX_TERM];
-                    snprintf(hyperword, sizeof(hyperword), "%s", hyper->words[w]);
-                    normalize_word(hyperword);
-                    if (!is_noise_token(hyperword)) {
-                        add_unique(related->hypernyms, &related->hypernym_count, MAX_LIST, hyperword);
-                        add_term_count(ctx, hyperword, 1);
-                    }
-                }
-                free_synset(hyper);
-            }
-        }
+    word = memo->text + memo->hypernyms;
+    for (i = 0; i < memo->hypernym_count; i++, word += strlen(word) + 1) {
+        add_unique(related->hypernyms, &related->hypernym_count, MAX_LIST, word);
+        add_term_count(ctx, word, 1);
     }
     (void)pos;
 }
 
-static void capture_top_concepts(struct concept *concepts, int concept_count,
+static void capture_top_concepts(int *scores,
                                  const char *type, char list[][MAX_TERM], int *out_count, int max_count)
 {
     int i;
@@ -1331,15 +1429,15 @@ static void capture_top_concepts(struct concept *concepts, int concept_count,
             if (strcmp(concepts[j].type, type) != 0) {
                 continue;
             }
-            if (best == -1 || concepts[j].score > concepts[best].score) {
+            if (best == -1 || scores[j] > scores[best]) {
                 best = j;
             }
         }
-        if (best == -1 || concepts[best].score <= 0) {
+        if (best == -1 || scores[best] <= 0) {
             break;
         }
         snprintf(list[printed], MAX_TERM, "%s", concepts[best].name);
-        concepts[best].score = -1;
+        scores[best] = -1;
         printed++;
     }
     *out_count = printed;
@@ -1347,8 +1445,7 @@ static void capture_top_concepts(struct concept *concepts, int concept_count,
 
 static void analyze_input(const char *input, struct chat_context *ctx, struct analysis_result *analysis)
 {
-    struct concept concepts[MAX_CONCEPTS];
-    int concept_count = 0;
+    int scores[MAX_CONCEPTS];
     char language[MAX_TERM];
     char platform[MAX_TERM];
     char framework[MAX_TERM];
@@ -1360,7 +1457,6 @@ static void analyze_input(const char *input, struct chat_context *ctx, struct an
     size_t j = 0;
 
     init_analysis(analysis);
-    init_concepts(concepts, &concept_count);
     ctx->turns++;
 
     if (strchr(input, '?') != NULL) {
@@ -1394,14 +1490,12 @@ static void analyze_input(const char *input, struct chat_context *ctx, struct an
 
             for (p = 0; p < 4; p++) {
                 int pos = pos_list[p];
-                IndexPtr idx = getindex(normalized, pos);
-                SynsetPtr syn;
+                const struct sense_memo *memo = lookup_sense_memo(normalized, pos);
+                const char *synword;
                 char lemma[MAX_TERM];
+                int w;
 
-                if (idx == NULL || idx->off_cnt == 0) {
-                    if (idx != NULL) {
-                        free_index(idx);
-                    }
+                if (!memo->found) {
                     continue;
                 }
                 matched_pos = 1;
@@ -1414,28 +1508,18 @@ static void analyze_input(const char *input, struct chat_context *ctx, struct an
                 } else if (pos == ADJ || pos == ADV) {
                     add_unique(analysis->qualifiers, &analysis->qualifier_count, MAX_LIST, lemma);
                 }
-                syn = read_synset(pos, idx->offset[0], lemma);
-                if (syn != NULL) {
-                    int w;
-                    for (w = 0; w < syn->wcount; w++) {
-                        char synword[MAX_TERM];
-                        snprintf(synword, sizeof(synword), "%s", syn->words[w]);
-                        normalize_word(synword);
-                        if (!is_noise_token(synword)) {
-                            if (pos == NOUN) {
-                                add_unique(analysis->entities, &analysis->entity_count, MAX_LIST, synword);
-                            } else if (pos == ADJ || pos == ADV) {
-                                add_unique(analysis->qualifiers, &analysis->qualifier_count, MAX_LIST, synword);
-                            } else if (pos == VERB) {
-                                add_unique(analysis->actions, &analysis->action_count, MAX_LIST, synword);
-                            }
-                        }
+                synword = memo->text + memo->synonyms;
+                for (w = 0; w < memo->synonym_count; w++, synword += strlen(synword) + 1) {
+                    if (pos == NOUN) {
+                        add_unique(analysis->entities, &analysis->entity_count, MAX_LIST, synword);
+                    } else if (pos == ADJ || pos == ADV) {
+                        add_unique(analysis->qualifiers, &analysis->qualifier_count, MAX_LIST, synword);
+                    } else if (pos == VERB) {
+                        add_unique(analysis->actions, &analysis->action_count, MAX_LIST, synword);
                     }
-                    fetch_related_terms(normalized, pos, syn, analysis, ctx);
-                    collect_memory_from_synset(ctx, syn);
-                    free_synset(syn);
                 }
-                free_index(idx);
+                fetch_related_terms(normalized, pos, memo, analysis, ctx);
+                collect_memory_from_memo(ctx, memo);
             }
             if (!matched_pos) {
                 add_unique(analysis->entities, &analysis->entity_count, MAX_LIST, normalized);
@@ -1457,15 +1541,15 @@ static void analyze_input(const char *input, struct chat_context *ctx, struct an
     language_score = extract_language(analysis->entities, analysis->entity_count, language, sizeof(language));
     platform_score = extract_platform(analysis->entities, analysis->entity_count, platform, sizeof(platform));
     framework_score = extract_framework(analysis->entities, analysis->entity_count, framework, sizeof(framework));
-    rank_concepts(concepts, concept_count, analysis->entities, analysis->entity_count, ctx, analysis);
+    rank_concepts(scores, analysis->entities, analysis->entity_count, ctx, analysis);
     merge_context(ctx, analysis->actions, analysis->action_count, analysis->entities, analysis->entity_count,
                   analysis->qualifiers, analysis->qualifier_count,
                   language, language_score,
                   platform, platform_score,
                   framework, framework_score);
-    capture_top_concepts(concepts, concept_count, "sdlc",
+    capture_top_concepts(scores, "sdlc",
                          analysis->sdlc_focus, &analysis->sdlc_focus_count, 2);
-    capture_top_concepts(concepts, concept_count, "design",
+    capture_top_concepts(scores, "design",
                          analysis->design_focus, &analysis->design_focus_count, 3);
 
     if (language_score > 0 || platform_score > 0 || framework_score > 0) {
@@ -1722,7 +1806,7 @@ static void reset_context(struct chat_context *ctx)
 static void print_help(const char *prog)
 {
     printf("DIY AI Chat (WordNet)\n");
-    printf("usage: %s\n", prog);
+    printf("usage: %s [--quiet] [--cache FILE | --no-cache]\n", prog);
     printf("\n");
     printf("commands:\n");
     printf("  /help        Show this help\n");
@@ -1804,6 +1888,8 @@ int main(int argc, char **argv)
     struct chat_context ctx;
     struct analysis_result analysis;
     int quiet = 0;
+    const char *cache_path = WORD_CACHE_FILE;
+    int i;
 
     memset(&ctx, 0, sizeof(ctx));
     set_default_searchdir();
@@ -1816,9 +1902,19 @@ int main(int argc, char **argv)
         load_chat_strings("diy-ai/chat_strings.json");
     }
 
-    if (argc > 1 && strcmp(argv[1], "--quiet") == 0) {
-        quiet = 1;
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            cache_path = NULL;
+        }
+    }
+    if (cache_path != NULL) {
+        word_cache_load(&cache, cache_path);
     }
+    init_concepts();
 
     printf("DIY AI Chat (type /help for commands)\n");
     while (1) {
@@ -1867,5 +1963,7 @@ int main(int argc, char **argv)
             generate_response(&ctx, &analysis);
         }
     }
+    free_sense_memos();
+    word_cache_close(&cache);
     return 0;
 }
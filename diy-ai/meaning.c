@@ -5,6 +5,8 @@
 
 #include <wn.h>
 
+#include "word_cache.h"
+
 #define MAX_WORDS 256
 #define MAX_TERM 64
 #define MAX_TERMS 512
@@ -162,66 +164,55 @@ static int compare_terms(const void *a, const void *b)
     return strcmp(ta->term, tb->term);
 }
 
-static void collect_from_synset(struct term_count *terms, int *term_count, SynsetPtr syn)
+/* Add the words and gloss of the sense, or of hypernym h if h >= 0 */
+static void collect_from_sense(struct term_count *terms, int *term_count,
+                               const struct word_sense *sense, int h)
 {
+    const char *gloss = word_sense_gloss(sense, h);
     int i;
 
-    if (syn == NULL) {
-        return;
-    }
-    for (i = 0; i < syn->wcount; i++) {
-        add_term(terms, term_count, syn->words[i], 2);
-        add_terms_from_text(terms, term_count, syn->words[i]);
+    for (i = 0; i < word_sense_count(sense, h); i++) {
+        add_term(terms, term_count, word_sense_word(sense, h, i), 2);
+        add_terms_from_text(terms, term_count, word_sense_word(sense, h, i));
     }
-    if (syn->defn != NULL) {
-        add_terms_from_text(terms, term_count, syn->defn);
+    if (gloss != NULL) {
+        add_terms_from_text(terms, term_count, gloss);
     }
 }
 
-static void collect_hypernyms(struct term_count *terms, int *term_count, SynsetPtr syn, int pos)
+static void collect_hypernyms(struct term_count *terms, int *term_count,
+                              const struct word_sense *sense, int pos)
 {
     int i;
 
-    if (syn == NULL) {
-        return;
-    }
     if (pos != NOUN && pos != VERB) {
         return;
     }
-    for (i = 0; i < syn->ptrcount; i++) {
-        SynsetPtr hyper;
-
-        if (syn->ptrtyp[i] != HYPERPTR) {
-            continue;
-        }
-        hyper = read_synset(pos, syn->ptroff[i], "");
-        if (hyper == NULL) {
-            continue;
-        }
-        collect_from_synset(terms, term_count, hyper);
-        free_synset(hyper);
+    for (i = 0; i < sense->hypernym_count; i++) {
+        collect_from_sense(terms, term_count, sense, i);
     }
 }
 
-static IndexPtr lookup_index(const char *word, int pos, char *resolved, size_t resolved_size)
+/* Look up the first sense of word in pos, trying its base form if the
+ * word itself isn't in WordNet, and leave the form found in resolved */
+static int lookup_sense(const struct word_cache *cache, const char *word, int pos,
+                        char *resolved, size_t resolved_size, struct word_sense *sense)
 {
-    IndexPtr idx;
     char *lemma;
 
     snprintf(resolved, resolved_size, "%s", word);
-    idx = getindex(resolved, pos);
-    if (idx != NULL) {
-        return idx;
+    if (word_sense_lookup(cache, resolved, pos, sense)) {
+        return 1;
     }
     lemma = morphstr(resolved, pos);
     if (lemma != NULL && lemma[0] != '\0') {
         snprintf(resolved, resolved_size, "%s", lemma);
-        idx = getindex(resolved, pos);
+        return word_sense_lookup(cache, resolved, pos, sense);
     }
-    return idx;
+    return 0;
 }
 
-static void explain_word(const char *word, int show_gloss)
+static void explain_word(const struct word_cache *cache, const char *word, int show_gloss)
 {
     int pos_list[] = { NOUN, VERB, ADJ, ADV };
     int i;
@@ -233,25 +224,15 @@ static void explain_word(const char *word, int show_gloss)
     for (i = 0; i < 4; i++) {
         int pos = pos_list[i];
         char resolved[MAX_TERM];
-        IndexPtr idx = lookup_index(word, pos, resolved, sizeof(resolved));
-        SynsetPtr syn;
+        struct word_sense sense;
 
-        if (idx == NULL || idx->off_cnt == 0) {
-            if (idx != NULL) {
-                free_index(idx);
-            }
-            continue;
-        }
-
-        syn = read_synset(pos, idx->offset[0], resolved);
-        if (syn != NULL) {
+        if (lookup_sense(cache, word, pos, resolved, sizeof(resolved), &sense)) {
             const char *pos_name = partnames[pos];
-            const char *gloss = syn->defn ? syn->defn : "(no gloss)";
+            const char *gloss = word_sense_gloss(&sense, -1);
 
-            printf("  %s: %s\n", pos_name, gloss);
-            free_synset(syn);
+            printf("  %s: %s\n", pos_name, gloss ? gloss : "(no gloss)");
+            word_sense_free(&sense);
         }
-        free_index(idx);
     }
 }
 
@@ -306,6 +287,8 @@ static void print_help(const char *prog)
     printf("  --no-gloss           Skip per-word gloss output\n");
     printf("  --no-hypernyms       Skip hypernym expansion\n");
     printf("  --json               Emit JSON for codegen pipelines\n");
+    printf("  --cache FILE         Read words from the wn-cache file (default %s)\n", WORD_CACHE_FILE);
+    printf("  --no-cache           Read words from the WordNet database\n");
     printf("\n");
     printf("examples:\n");
     printf("  %s \"add caching to reduce latency\"\n", prog);
@@ -340,6 +323,8 @@ int main(int argc, char **argv)
     int use_hypernyms = 1;
     int top_n = DEFAULT_TOP;
     int emit_json = 0;
+    const char *cache_path = WORD_CACHE_FILE;
+    struct word_cache cache;
     char actions[MAX_LIST][MAX_TERM];
     char entities[MAX_LIST][MAX_TERM];
     char qualities[MAX_LIST][MAX_TERM];
@@ -385,6 +370,18 @@ int main(int argc, char **argv)
             i++;
             continue;
         }
+        if (strcmp(argv[i], "--cache") == 0) {
+            if (i + 1 >= (size_t)argc) {
+                fprintf(stderr, "Missing value for --cache\n");
+                return 1;
+            }
+            cache_path = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--no-cache") == 0) {
+            cache_path = NULL;
+            continue;
+        }
     }
 
     set_default_searchdir();
@@ -398,11 +395,14 @@ int main(int argc, char **argv)
         fprintf(stderr, "WNSEARCHDIR=%s\n", env_search ? env_search : "(unset)");
         return 1;
     }
+    if (cache_path == NULL || word_cache_load(&cache, cache_path) != 0) {
+        memset(&cache, 0, sizeof(cache));
+    }
 
     input[0] = '\0';
     for (i = 1; i < (size_t)argc; i++) {
         if (argv[i][0] == '-' && argv[i][1] != '\0') {
-            if (strcmp(argv[i], "--top") == 0) {
+            if (strcmp(argv[i], "--top") == 0 || strcmp(argv[i], "--cache") == 0) {
                 i++;
             }
             continue;
@@ -441,7 +441,7 @@ int main(int argc, char **argv)
                 continue;
             }
             if (word_count++ < MAX_WORDS) {
-                explain_word(word, show_gloss);
+                explain_word(&cache, word, show_gloss);
             }
 
             {
@@ -450,13 +450,9 @@ int main(int argc, char **argv)
                 for (p = 0; p < 4; p++) {
                     int pos = pos_list[p];
                     char resolved[MAX_TERM];
-                    IndexPtr idx = lookup_index(word, pos, resolved, sizeof(resolved));
-                    SynsetPtr syn;
+                    struct word_sense sense;
 
-                    if (idx == NULL || idx->off_cnt == 0) {
-                        if (idx != NULL) {
-                            free_index(idx);
-                        }
+                    if (!lookup_sense(&cache, word, pos, resolved, sizeof(resolved), &sense)) {
                         continue;
                     }
                     if (pos == VERB) {
@@ -472,15 +468,11 @@ int main(int argc, char **argv)
                         adv_hits++;
                         add_unique(adverbs, &adverb_count, resolved);
                     }
-                    syn = read_synset(pos, idx->offset[0], resolved);
-                    if (syn != NULL) {
-                        collect_from_synset(terms, &term_count, syn);
-                        if (use_hypernyms) {
-                            collect_hypernyms(terms, &term_count, syn, pos);
-                        }
-                        free_synset(syn);
+                    collect_from_sense(terms, &term_count, &sense, -1);
+                    if (use_hypernyms) {
+                        collect_hypernyms(terms, &term_count, &sense, pos);
                     }
-                    free_index(idx);
+                    word_sense_free(&sense);
                 }
             }
         }
@@ -493,6 +485,7 @@ int main(int argc, char **argv)
         for (i = 0; i < (size_t)term_count && i < (size_t)top_n; i++) {
             printf("  %s (%d)\n", terms[i].term, terms[i].count);
         }
+        word_cache_close(&cache);
         return 0;
     }
 
@@ -538,5 +531,6 @@ int main(int argc, char **argv)
     printf("]\n");
     printf("}\n");
 
+    word_cache_close(&cache);
     return 0;
 }
@@ -1,13 +1,81 @@
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
 
 #include <wn.h>
 
+#include "word_cache.h"
+
 #define MAX_TERM 128
 #define MAX_LIST 8
 #define MAX_LINE 4096
+#define CHUNK_LINES 1024
+#define MAX_JOBS 64
+#define OUT_BUFSIZE (1 << 20)
+#define NUM_SEGMENTS 4
+#define MANIFEST_FILE "manifest"
+#define MANIFEST_VERSION 1      /* change when entries are rendered differently */
+
+/* Growable output buffer.  Entries are rendered into one of these and
+   written out with a single fwrite(). */
+struct jbuf {
+    char *data;
+    size_t len;
+    size_t size;
+};
+
+/* Index file lines, as fgets() returned them, in one string pool */
+struct linelist {
+    char *pool;
+    size_t pool_len;
+    size_t pool_size;
+    size_t *start;
+    long count;
+    long size;
+};
+
+/* Rendered entries of one chunk of lines, back to back in text.  Each
+   entry's JSON is followed by its binary cache record, if wanted. */
+struct chunk {
+    struct jbuf text;
+    struct jbuf rec;            /* record of the entry being rendered */
+    int *lens;
+    int *reclens;
+    int count;
+    int size;
+};
+
+/* Where rendered chunks go: the JSON output, the binary cache if
+   wanted, and the segment being built, if any */
+struct sink {
+    struct word_cache_builder *builder;
+    FILE *segment;
+    int failed;                 /* segment couldn't be written */
+    int emitted;
+    int limit;
+};
+
+/* The entries of one index file are kept in a segment, a file of the
+   chunks rendered from it, so a later run whose inputs for that index
+   file are the same can copy them instead of rendering them again.
+   The manifest records the hashes of the index and data files each
+   segment was built from, and its size. */
+struct segment {
+    unsigned long long index_hash;
+    unsigned long long data_hash;
+    long size;                  /* -1 if there's no usable segment */
+};
+
+static const char *segment_names[NUM_SEGMENTS] = { "noun", "verb", "adj", "adv" };
 
 static void set_default_searchdir(void)
 {
@@ -27,24 +95,91 @@ static void set_default_searchdir(void)
 #endif
 }
 
-static void json_escape(const char *text)
+static int make_dir(const char *path)
+{
+#ifdef _WIN32
+    if (_mkdir(path) == 0) {
+        return 0;
+    }
+#else
+    if (mkdir(path, 0777) == 0) {
+        return 0;
+    }
+#endif
+    return errno == EEXIST ? 0 : -1;
+}
+
+static void *xrealloc(void *ptr, size_t size)
+{
+    void *p = realloc(ptr, size);
+
+    if (p == NULL) {
+        fprintf(stderr, "wn-cache: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void jb_write(struct jbuf *b, const char *text, size_t n)
+{
+    if (b->len + n + 1 > b->size) {
+        size_t size = b->size ? b->size : 4096;
+        while (b->len + n + 1 > size) {
+            size *= 2;
+        }
+        b->data = xrealloc(b->data, size);
+        b->size = size;
+    }
+    memcpy(b->data + b->len, text, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+static void jb_puts(struct jbuf *b, const char *text)
+{
+    jb_write(b, text, strlen(text));
+}
+
+/* Append text and its terminating NUL, as a field of a cache record */
+static void jb_field(struct jbuf *b, const char *text)
+{
+    jb_write(b, text, strlen(text) + 1);
+}
+
+static void jb_number(struct jbuf *b, long n)
+{
+    char num[32];
+
+    snprintf(num, sizeof(num), "%ld", n);
+    jb_field(b, num);
+}
+
+static void json_escape(struct jbuf *b, const char *text)
 {
     const unsigned char *p = (const unsigned char *)text;
+    char esc[8];
 
     while (*p) {
-        unsigned char c = *p++;
+        const unsigned char *run = p;
+        unsigned char c;
+
+        while (*p >= 32 && *p != '\\' && *p != '"') {
+            p++;
+        }
+        jb_write(b, (const char *)run, p - run);
+        if ((c = *p) == '\0') {
+            break;
+        }
+        p++;
         switch (c) {
-            case '\\': printf("\\\\"); break;
-            case '"': printf("\\\""); break;
-            case '\n': printf("\\n"); break;
-            case '\r': printf("\\r"); break;
-            case '\t': printf("\\t"); break;
+            case '\\': jb_puts(b, "\\\\"); break;
+            case '"': jb_puts(b, "\\\""); break;
+            case '\n': jb_puts(b, "\\n"); break;
+            case '\r': jb_puts(b, "\\r"); break;
+            case '\t': jb_puts(b, "\\t"); break;
             default:
-                if (c < 32) {
-                    printf("\\u%04x", c);
-                } else {
-                    putchar(c);
-                }
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                jb_puts(b, esc);
         }
     }
 }
@@ -149,128 +284,668 @@ static int parse_index_line(char *line, char **lemma_out, int *pos_out, long *of
     }
 }
 
-static void emit_json_list(char list[][MAX_TERM], int count)
+static void emit_json_list(struct jbuf *b, char list[][MAX_TERM], int count)
 {
     int i;
 
-    printf("[");
+    jb_puts(b, "[");
     for (i = 0; i < count; i++) {
         if (i > 0) {
-            printf(", ");
+            jb_puts(b, ", ");
+        }
+        jb_puts(b, "\"");
+        json_escape(b, list[i]);
+        jb_puts(b, "\"");
+    }
+    jb_puts(b, "]");
+}
+
+/* Append a synset to a cache record: part of speech, offset, words
+   and gloss, as fields. */
+static void record_synset(struct jbuf *rec, int pos, SynsetPtr syn)
+{
+    int i;
+
+    jb_number(rec, pos);
+    jb_number(rec, syn->hereiam);
+    jb_number(rec, syn->wcount);
+    for (i = 0; i < syn->wcount; i++) {
+        jb_field(rec, syn->words[i]);
+    }
+    jb_number(rec, syn->defn != NULL);
+    if (syn->defn != NULL) {
+        jb_field(rec, syn->defn);
+    }
+}
+
+/* Render the cache entry for one index file line into b, and if rec
+   isn't NULL its binary cache record, the lemma, part of speech, first
+   sense and its hypernyms, into rec.  Returns 1, or 0 if the line has
+   no entry. */
+static int render_entry(const char *line, struct jbuf *b, struct jbuf *rec)
+{
+    char buf[MAX_LINE];
+    char *lemma = NULL;
+    int pos = 0;
+    long offset = 0;
+    SynsetPtr syn;
+    char gloss[MAX_TERM * 2];
+    char synonyms[MAX_LIST][MAX_TERM];
+    char hypernyms[MAX_LIST][MAX_TERM];
+    char posbuf[32];
+    int syn_count = 0;
+    int hyper_count = 0;
+    int i;
+
+    if (line[0] == ' ' || line[0] == '\n') {
+        return 0;
+    }
+    snprintf(buf, sizeof(buf), "%s", line);
+    if (!parse_index_line(buf, &lemma, &pos, &offset)) {
+        return 0;
+    }
+    syn = read_synset(pos, offset, lemma);
+    if (syn == NULL) {
+        return 0;
+    }
+    if (rec != NULL) {
+        jb_field(rec, lemma);
+        jb_number(rec, pos);
+        record_synset(rec, pos, syn);
+    }
+    for (i = 0; i < syn->wcount; i++) {
+        char term[MAX_TERM];
+        snprintf(term, sizeof(term), "%s", syn->words[i]);
+        normalize_word(term);
+        add_unique(synonyms, &syn_count, MAX_LIST, term);
+    }
+    for (i = 0; i < syn->ptrcount; i++) {
+        if (syn->ptrtyp[i] != HYPERPTR) {
+            continue;
+        }
+        if (syn->ppos[i] == 0) {
+            continue;
+        }
+        SynsetPtr hyper = read_synset(syn->ppos[i], syn->ptroff[i], lemma);
+        if (hyper != NULL) {
+            int w;
+            if (rec != NULL) {
+                record_synset(rec, syn->ppos[i], hyper);
+            }
+            for (w = 0; w < hyper->wcount; w++) {
+                char term[MAX_TERM];
+                snprintf(term, sizeof(term), "%s", hyper->words[w]);
+                normalize_word(term);
+                add_unique(hypernyms, &hyper_count, MAX_LIST, term);
+            }
+            free_synset(hyper);
         }
-        printf("\"");
-        json_escape(list[i]);
-        printf("\"");
     }
-    printf("]");
+    gloss[0] = '\0';
+    if (syn->defn != NULL) {
+        shorten_gloss(syn->defn, gloss, sizeof(gloss));
+    }
+    jb_puts(b, "  {\n");
+    jb_puts(b, "    \"lemma\": \"");
+    json_escape(b, lemma);
+    jb_puts(b, "\",\n");
+    snprintf(posbuf, sizeof(posbuf), "    \"pos\": %d,\n", pos);
+    jb_puts(b, posbuf);
+    jb_puts(b, "    \"gloss\": \"");
+    json_escape(b, gloss);
+    jb_puts(b, "\",\n");
+    jb_puts(b, "    \"synonyms\": ");
+    emit_json_list(b, synonyms, syn_count);
+    jb_puts(b, ",\n");
+    jb_puts(b, "    \"hypernyms\": ");
+    emit_json_list(b, hypernyms, hyper_count);
+    jb_puts(b, "\n  }");
+    free_synset(syn);
+    return 1;
 }
 
-static void process_index_file(const char *path, int *emitted, int limit)
+/* Append the lines of an index file to lines, split as fgets() into a
+   MAX_LINE buffer splits them. */
+static void read_index_file(const char *path, struct linelist *lines)
 {
     FILE *fp = fopen(path, "r");
     char line[MAX_LINE];
+    size_t len;
 
     if (fp == NULL) {
         return;
     }
     while (fgets(line, sizeof(line), fp) != NULL) {
-        char buf[MAX_LINE];
-        char *lemma = NULL;
-        int pos = 0;
-        long offset = 0;
-        SynsetPtr syn;
-        char gloss[MAX_TERM * 2];
-        char synonyms[MAX_LIST][MAX_TERM];
-        char hypernyms[MAX_LIST][MAX_TERM];
-        int syn_count = 0;
-        int hyper_count = 0;
-        int i;
-
-        if (line[0] == ' ' || line[0] == '\n') {
-            continue;
+        len = strlen(line) + 1;
+        if (lines->pool_len + len > lines->pool_size) {
+            lines->pool_size = lines->pool_size ? lines->pool_size * 2 : 1 << 20;
+            lines->pool = xrealloc(lines->pool, lines->pool_size);
         }
-        snprintf(buf, sizeof(buf), "%s", line);
-        if (!parse_index_line(buf, &lemma, &pos, &offset)) {
-            continue;
+        if (lines->count == lines->size) {
+            lines->size = lines->size ? lines->size * 2 : 65536;
+            lines->start = xrealloc(lines->start, lines->size * sizeof(size_t));
         }
-        syn = read_synset(pos, offset, lemma);
-        if (syn == NULL) {
+        memcpy(lines->pool + lines->pool_len, line, len);
+        lines->start[lines->count++] = lines->pool_len;
+        lines->pool_len += len;
+    }
+    fclose(fp);
+}
+
+/* Render the entries for chunk number n of lines, each followed by its
+   cache record if records is set */
+static void render_chunk(struct linelist *lines, long n, int records, struct chunk *c)
+{
+    long i = n * CHUNK_LINES;
+    long end = i + CHUNK_LINES < lines->count ? i + CHUNK_LINES : lines->count;
+    size_t before;
+
+    c->text.len = 0;
+    c->count = 0;
+    for (; i < end; i++) {
+        before = c->text.len;
+        c->rec.len = 0;
+        if (!render_entry(lines->pool + lines->start[i], &c->text, records ? &c->rec : NULL)) {
             continue;
         }
-        for (i = 0; i < syn->wcount; i++) {
-            char term[MAX_TERM];
-            snprintf(term, sizeof(term), "%s", syn->words[i]);
-            normalize_word(term);
-            add_unique(synonyms, &syn_count, MAX_LIST, term);
+        if (c->count == c->size) {
+            c->size = c->size ? c->size * 2 : CHUNK_LINES;
+            c->lens = xrealloc(c->lens, c->size * sizeof(int));
+            c->reclens = xrealloc(c->reclens, c->size * sizeof(int));
         }
-        for (i = 0; i < syn->ptrcount; i++) {
-            if (syn->ptrtyp[i] != HYPERPTR) {
-                continue;
+        c->lens[c->count] = (int)(c->text.len - before);
+        c->reclens[c->count++] = (int)c->rec.len;
+        if (c->rec.len > 0) {
+            jb_write(&c->text, c->rec.data, c->rec.len);
+        }
+    }
+}
+
+static const char *next_field(const char **p, const char *end)
+{
+    const char *field = *p;
+
+    if (field >= end) {
+        return "";
+    }
+    *p += strlen(field) + 1;
+    return field;
+}
+
+/* Add the synset at *p in a cache record to the cache */
+static uint32_t add_record_synset(struct word_cache_builder *builder, const char **p,
+                                  const char *end)
+{
+    static const char **words;
+    static int words_size;
+    int pos = atoi(next_field(p, end));
+    long offset = atol(next_field(p, end));
+    int wcount = atoi(next_field(p, end));
+    const char *gloss = NULL;
+    int i;
+
+    if (wcount > words_size) {
+        words_size = wcount;
+        words = xrealloc(words, words_size * sizeof(*words));
+    }
+    for (i = 0; i < wcount; i++) {
+        words[i] = next_field(p, end);
+    }
+    if (atoi(next_field(p, end))) {
+        gloss = next_field(p, end);
+    }
+    return word_cache_add_synset(builder, pos, offset, wcount, words, gloss);
+}
+
+/* Add the entry in a cache record, as render_entry() wrote it, to the
+   cache */
+static void add_record(struct word_cache_builder *builder, const char *rec, int len)
+{
+    static uint32_t *hypernyms;
+    static int hypernyms_size;
+    const char *p = rec;
+    const char *end = rec + len;
+    const char *lemma;
+    uint32_t synset;
+    int pos;
+    int count = 0;
+
+    if (len == 0) {
+        return;
+    }
+    lemma = next_field(&p, end);
+    pos = atoi(next_field(&p, end));
+    synset = add_record_synset(builder, &p, end);
+    while (p < end) {
+        if (count == hypernyms_size) {
+            hypernyms_size = hypernyms_size ? hypernyms_size * 2 : 16;
+            hypernyms = xrealloc(hypernyms, hypernyms_size * sizeof(uint32_t));
+        }
+        hypernyms[count++] = add_record_synset(builder, &p, end);
+    }
+    word_cache_add_entry(builder, lemma, pos, synset, hypernyms, count);
+}
+
+/* Write the chunk, framed as its entry count, entry and record lengths
+   and text.  Returns -1 if it couldn't be written. */
+static int write_chunk(FILE *out, struct chunk *c)
+{
+    if (fwrite(&c->count, sizeof(int), 1, out) != 1 ||
+        fwrite(c->lens, sizeof(int), c->count, out) != (size_t)c->count ||
+        fwrite(c->reclens, sizeof(int), c->count, out) != (size_t)c->count ||
+        fwrite(c->text.data, 1, c->text.len, out) != c->text.len) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Read the next chunk written by write_chunk() into c.  Returns -1 at
+   the end of the file or if the writer died. */
+static int read_chunk(FILE *in, struct chunk *c)
+{
+    size_t len = 0;
+    int i;
+
+    if (fread(&c->count, sizeof(int), 1, in) != 1 || c->count < 0) {
+        return -1;
+    }
+    if (c->count > c->size) {
+        c->size = c->count;
+        c->lens = xrealloc(c->lens, c->size * sizeof(int));
+        c->reclens = xrealloc(c->reclens, c->size * sizeof(int));
+    }
+    if (fread(c->lens, sizeof(int), c->count, in) != (size_t)c->count ||
+        fread(c->reclens, sizeof(int), c->count, in) != (size_t)c->count) {
+        return -1;
+    }
+    for (i = 0; i < c->count; i++) {
+        len += c->lens[i] + c->reclens[i];
+    }
+    if (len + 1 > c->text.size) {
+        c->text.size = len + 1;
+        c->text.data = xrealloc(c->text.data, c->text.size);
+    }
+    if (fread(c->text.data, 1, len, in) != len) {
+        return -1;
+    }
+    c->text.len = len;
+    return 0;
+}
+
+/* Save the chunk to the segment being built, if any, and write its
+   entries, up to the limit in all, adding their records to the binary
+   cache if one is wanted.  Returns 1 once the limit is reached. */
+static int merge_chunk(struct chunk *c, struct sink *sink)
+{
+    const char *p = c->text.data;
+    int i;
+
+    if (sink->segment != NULL && write_chunk(sink->segment, c) != 0) {
+        sink->failed = 1;
+    }
+    for (i = 0; i < c->count; i++) {
+        if (sink->emitted > 0) {
+            fputs(",\n", stdout);
+        }
+        fwrite(p, 1, c->lens[i], stdout);
+        p += c->lens[i];
+        if (sink->builder != NULL) {
+            add_record(sink->builder, p, c->reclens[i]);
+        }
+        p += c->reclens[i];
+        sink->emitted++;
+        if (sink->limit > 0 && sink->emitted >= sink->limit) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void free_chunk(struct chunk *c)
+{
+    free(c->text.data);
+    free(c->rec.data);
+    free(c->lens);
+    free(c->reclens);
+}
+
+/* Records are rendered if there's a binary cache or a segment to keep
+   them for */
+static int want_records(struct sink *sink)
+{
+    return sink->builder != NULL || sink->segment != NULL;
+}
+
+/* Returns 1 if the limit cut the cache short */
+static int build_serial(struct linelist *lines, struct sink *sink)
+{
+    struct chunk c;
+    int truncated = 0;
+    long n;
+
+    memset(&c, 0, sizeof(c));
+    for (n = 0; n * CHUNK_LINES < lines->count; n++) {
+        render_chunk(lines, n, want_records(sink), &c);
+        if (merge_chunk(&c, sink)) {
+            truncated = 1;
+            break;
+        }
+    }
+    free_chunk(&c);
+    return truncated;
+}
+
+#ifndef _WIN32
+
+/* Worker w renders chunks w, w + jobs, w + 2 * jobs ... and writes each
+   to out. */
+static void cache_worker(struct linelist *lines, int w, int jobs, int records, FILE *out)
+{
+    struct chunk c;
+    long n;
+
+    if (re_wninit() != 0) {     /* get our own file positions */
+        fprintf(stderr, "wn-cache: cannot open WordNet database\n");
+        _exit(1);
+    }
+    memset(&c, 0, sizeof(c));
+    for (n = w; n * CHUNK_LINES < lines->count; n += jobs) {
+        render_chunk(lines, n, records, &c);
+        if (write_chunk(out, &c) != 0 || fflush(out) != 0) {
+            _exit(1);
+        }
+    }
+    _exit(0);
+}
+
+/* Render the chunks on jobs worker processes, each with its own file
+   positions as the library isn't reentrant, and write them in order.
+   Chunk n comes from worker n % jobs, and a worker blocks once its pipe
+   is full, so only a few chunks per worker are ever in memory.  Returns
+   -1 if the workers couldn't be started or one of them failed, 1 if the
+   limit cut the cache short. */
+static int build_parallel(struct linelist *lines, int jobs, struct sink *sink)
+{
+    pid_t pids[MAX_JOBS];
+    FILE *in[MAX_JOBS];
+    struct chunk c;
+    int fds[2];
+    int started = 0;
+    int err = 0;
+    long n;
+    int i;
+
+    fflush(stdout);
+    for (i = 0; i < jobs; i++) {
+        if (pipe(fds) != 0) {
+            break;
+        }
+        if ((pids[i] = fork()) == 0) {
+            FILE *out;
+            int j;
+            for (j = 0; j < i; j++) {
+                fclose(in[j]);
             }
-            if (syn->ppos[i] == 0) {
-                continue;
+            close(fds[0]);
+            if ((out = fdopen(fds[1], "w")) == NULL) {
+                _exit(1);
+            }
+            setvbuf(out, NULL, _IOFBF, OUT_BUFSIZE);
+            cache_worker(lines, i, jobs, want_records(sink), out);
+        }
+        close(fds[1]);
+        if (pids[i] < 0 || (in[i] = fdopen(fds[0], "r")) == NULL) {
+            close(fds[0]);
+            break;
+        }
+        started++;
+    }
+
+    if (started < jobs) {
+        err = -1;
+    } else {
+        memset(&c, 0, sizeof(c));
+        for (n = 0; n * CHUNK_LINES < lines->count; n++) {
+            if (read_chunk(in[n % jobs], &c) != 0) {
+                err = -1;
+                break;
+            }
+            if (merge_chunk(&c, sink)) {
+                err = 1;
+                break;
             }
-            SynsetPtr hyper = read_synset(syn->ppos[i], syn->ptroff[i], lemma);
-            if (hyper != NULL) {
-                int w;
-                for (w = 0; w < hyper->wcount; w++) {
-                    char term[MAX_TERM];
-                    snprintf(term, sizeof(term), "%s", hyper->words[w]);
-                    normalize_word(term);
-                    add_unique(hypernyms, &hyper_count, MAX_LIST, term);
-                }
-                free_synset(hyper);
+        }
+        free_chunk(&c);
+    }
+
+    /* Workers still going when the limit is reached get SIGPIPE */
+    for (i = 0; i < started; i++) {
+        int status;
+        fclose(in[i]);
+        waitpid(pids[i], &status, 0);
+    }
+    return err;
+}
+
+#endif /* _WIN32 */
+
+/* FNV-1a hash of the contents of a file.  Returns -1 if it can't be
+   read. */
+static int hash_file(const char *path, unsigned long long *hash)
+{
+    FILE *fp = fopen(path, "rb");
+    unsigned char buf[65536];
+    unsigned long long h = 14695981039346656037ULL;
+    size_t n, i;
+
+    if (fp == NULL) {
+        return -1;
+    }
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        for (i = 0; i < n; i++) {
+            h ^= buf[i];
+            h *= 1099511628211ULL;
+        }
+    }
+    fclose(fp);
+    *hash = h;
+    return 0;
+}
+
+static long file_size(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    long size;
+
+    if (fp == NULL) {
+        return -1;
+    }
+    fseek(fp, 0L, SEEK_END);
+    size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+/* Read the manifest in dir into segments.  A segment it doesn't list,
+   or every segment if there is no manifest of this version, is left
+   with size -1. */
+static void read_manifest(const char *dir, struct segment *segments)
+{
+    char path[512];
+    char line[256];
+    char name[32];
+    struct segment seg;
+    FILE *fp;
+    int version = 0;
+    int i;
+
+    for (i = 0; i < NUM_SEGMENTS; i++) {
+        segments[i].size = -1;
+    }
+    snprintf(path, sizeof(path), "%s/%s", dir, MANIFEST_FILE);
+    if ((fp = fopen(path, "r")) == NULL) {
+        return;
+    }
+    if (fgets(line, sizeof(line), fp) == NULL ||
+        sscanf(line, "wn-cache manifest %d", &version) != 1 ||
+        version != MANIFEST_VERSION) {
+        fclose(fp);
+        return;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "%31s %llx %llx %ld", name, &seg.index_hash,
+                   &seg.data_hash, &seg.size) != 4) {
+            continue;
+        }
+        for (i = 0; i < NUM_SEGMENTS; i++) {
+            if (strcmp(name, segment_names[i]) == 0) {
+                segments[i] = seg;
             }
         }
-        gloss[0] = '\0';
-        if (syn->defn != NULL) {
-            shorten_gloss(syn->defn, gloss, sizeof(gloss));
-        }
-        if (*emitted > 0) {
-            printf(",\n");
-        }
-        printf("  {\n");
-        printf("    \"lemma\": \"");
-        json_escape(lemma);
-        printf("\",\n");
-        printf("    \"pos\": %d,\n", pos);
-        printf("    \"gloss\": \"");
-        json_escape(gloss);
-        printf("\",\n");
-        printf("    \"synonyms\": ");
-        emit_json_list(synonyms, syn_count);
-        printf(",\n");
-        printf("    \"hypernyms\": ");
-        emit_json_list(hypernyms, hyper_count);
-        printf("\n  }");
-        free_synset(syn);
-
-        (*emitted)++;
-        if (limit > 0 && *emitted >= limit) {
+    }
+    fclose(fp);
+}
+
+/* Write the manifest, replacing the old one only once it's complete.
+   Returns -1 if it couldn't be written. */
+static int write_manifest(const char *dir, const struct segment *segments)
+{
+    char path[512];
+    char tmp[520];
+    FILE *fp;
+    int err = 0;
+    int i;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, MANIFEST_FILE);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    if ((fp = fopen(tmp, "w")) == NULL) {
+        return -1;
+    }
+    fprintf(fp, "wn-cache manifest %d\n", MANIFEST_VERSION);
+    for (i = 0; i < NUM_SEGMENTS; i++) {
+        if (segments[i].size >= 0) {
+            fprintf(fp, "%s %016llx %016llx %ld\n", segment_names[i],
+                    segments[i].index_hash, segments[i].data_hash, segments[i].size);
+        }
+    }
+    if (ferror(fp)) {
+        err = -1;
+    }
+    if (fclose(fp) != 0) {
+        err = -1;
+    }
+    if (err != 0 || rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* Write the entries saved in a segment.  Returns 1 if the limit was
+   reached, or -1 if the segment couldn't be read. */
+static int splice_segment(const char *path, struct sink *sink)
+{
+    FILE *fp = fopen(path, "rb");
+    struct chunk c;
+    int truncated = 0;
+
+    if (fp == NULL) {
+        return -1;
+    }
+    setvbuf(fp, NULL, _IOFBF, OUT_BUFSIZE);
+    memset(&c, 0, sizeof(c));
+    while (read_chunk(fp, &c) == 0) {
+        if (merge_chunk(&c, sink)) {
+            truncated = 1;
             break;
         }
     }
+    free_chunk(&c);
     fclose(fp);
+    return truncated;
+}
+
+/* Render the entries of one index file, on jobs workers where
+   possible.  Returns 1 if the limit was reached, or -1 if a worker
+   failed after entries were written. */
+static int build_segment(const char *index_path, int jobs, struct linelist *lines,
+                         struct sink *sink, const char *segment_path)
+{
+    long chunks;
+
+    lines->count = 0;
+    lines->pool_len = 0;
+    read_index_file(index_path, lines);
+    chunks = (lines->count + CHUNK_LINES - 1) / CHUNK_LINES;
+    if (jobs > chunks) {
+        jobs = (int)chunks;
+    }
+#ifndef _WIN32
+    if (jobs > 1) {
+        int before = sink->emitted;
+        int truncated = build_parallel(lines, jobs, sink);
+
+        if (truncated >= 0) {
+            return truncated;
+        }
+        if (sink->emitted != before) {
+            return -1;
+        }
+        /* couldn't start workers; start the segment again */
+        if (sink->segment != NULL) {
+            fclose(sink->segment);
+            sink->segment = fopen(segment_path, "wb");
+        }
+    }
+#endif
+    (void)segment_path;
+    return build_serial(lines, sink);
 }
 
 int main(int argc, char **argv)
 {
     const char *out_path = "word_cache.json";
+    const char *bin_path = WORD_CACHE_FILE;
+    const char *segment_dir = "word_cache.d";
+    int rebuild = 0;
     int limit = 0;
+    int jobs = 1;
     int i;
     FILE *out;
     const char *searchdir;
     char pathbuf[512];
-    int emitted = 0;
+    char segpath[512];
+    char tmppath[520];
+    int truncated = 0;
+    int rebuilt = 0;
+    struct sink sink;
+    struct segment segments[NUM_SEGMENTS];
+    struct linelist lines;
 
+#ifndef _WIN32
+    jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
     for (i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
             out_path = argv[++i];
+        } else if (strcmp(argv[i], "--bin") == 0 && i + 1 < argc) {
+            bin_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-bin") == 0) {
+            bin_path = NULL;
+        } else if (strcmp(argv[i], "--segments") == 0 && i + 1 < argc) {
+            segment_dir = argv[++i];
+        } else if (strcmp(argv[i], "--no-segments") == 0) {
+            segment_dir = NULL;
+        } else if (strcmp(argv[i], "--rebuild") == 0) {
+            rebuild = 1;
         } else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
             limit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
         } else if (strcmp(argv[i], "--help") == 0) {
             printf("wn-cache: build a WordNet cache\n");
-            printf("usage: %s [--out FILE] [--limit N]\n", argv[0]);
+            printf("usage: %s [--out FILE] [--bin FILE | --no-bin] [--limit N] [--jobs N]\n", argv[0]);
+            printf("       [--segments DIR | --no-segments] [--rebuild]\n");
             return 0;
         }
     }
@@ -285,30 +960,99 @@ int main(int argc, char **argv)
         fprintf(stderr, "WNSEARCHDIR not set.\n");
         return 1;
     }
+    if (jobs > MAX_JOBS) {
+        jobs = MAX_JOBS;
+    }
+
+    for (i = 0; i < NUM_SEGMENTS; i++) {
+        segments[i].size = -1;
+    }
+    if (segment_dir != NULL) {
+        if (make_dir(segment_dir) != 0) {
+            fprintf(stderr, "wn-cache: cannot create %s, building without segments\n", segment_dir);
+            segment_dir = NULL;
+        } else if (!rebuild) {
+            read_manifest(segment_dir, segments);
+        }
+    }
 
     out = freopen(out_path, "w", stdout);
     if (out == NULL) {
         fprintf(stderr, "Failed to open %s\n", out_path);
         return 1;
     }
+    setvbuf(stdout, NULL, _IOFBF, OUT_BUFSIZE);
+    memset(&sink, 0, sizeof(sink));
+    sink.limit = limit;
+    if (bin_path != NULL) {
+        sink.builder = word_cache_builder_new();
+    }
+    memset(&lines, 0, sizeof(lines));
 
     printf("{\n  \"entries\": [\n");
-    snprintf(pathbuf, sizeof(pathbuf), "%s/index.noun", searchdir);
-    process_index_file(pathbuf, &emitted, limit);
-    if (limit <= 0 || emitted < limit) {
-        snprintf(pathbuf, sizeof(pathbuf), "%s/index.verb", searchdir);
-        process_index_file(pathbuf, &emitted, limit);
-    }
-    if (limit <= 0 || emitted < limit) {
-        snprintf(pathbuf, sizeof(pathbuf), "%s/index.adj", searchdir);
-        process_index_file(pathbuf, &emitted, limit);
-    }
-    if (limit <= 0 || emitted < limit) {
-        snprintf(pathbuf, sizeof(pathbuf), "%s/index.adv", searchdir);
-        process_index_file(pathbuf, &emitted, limit);
+    for (i = 0; i < NUM_SEGMENTS && !truncated; i++) {
+        struct segment seg;
+        int have_inputs;
+
+        snprintf(pathbuf, sizeof(pathbuf), "%s/index.%s", searchdir, segment_names[i]);
+        have_inputs = segment_dir != NULL && hash_file(pathbuf, &seg.index_hash) == 0;
+        if (have_inputs) {
+            char datapath[512];
+            snprintf(datapath, sizeof(datapath), "%s/data.%s", searchdir, segment_names[i]);
+            have_inputs = hash_file(datapath, &seg.data_hash) == 0;
+        }
+
+        if (have_inputs) {
+            snprintf(segpath, sizeof(segpath), "%s/%s.seg", segment_dir, segment_names[i]);
+            if (segments[i].size >= 0 && segments[i].index_hash == seg.index_hash &&
+                segments[i].data_hash == seg.data_hash &&
+                file_size(segpath) == segments[i].size &&
+                (truncated = splice_segment(segpath, &sink)) >= 0) {
+                continue;
+            }
+            truncated = 0;
+            snprintf(tmppath, sizeof(tmppath), "%s.tmp", segpath);
+            sink.segment = fopen(tmppath, "wb");
+            sink.failed = 0;
+        }
+
+        truncated = build_segment(pathbuf, jobs, &lines, &sink, tmppath);
+        if (truncated < 0) {
+            fprintf(stderr, "wn-cache: worker failed\n");
+            fclose(out);
+            return 1;
+        }
+        rebuilt++;
+        if (sink.segment != NULL) {
+            /* a segment the limit cut short is thrown away */
+            if (fclose(sink.segment) != 0) {
+                sink.failed = 1;
+            }
+            sink.segment = NULL;
+            segments[i].size = -1;
+            if (!truncated && !sink.failed && rename(tmppath, segpath) == 0) {
+                seg.size = file_size(segpath);
+                segments[i] = seg;
+            } else {
+                remove(tmppath);
+            }
+        }
     }
-    printf("\n  ],\n  \"count\": %d\n}\n", emitted);
+    printf("\n  ],\n  \"count\": %d\n}\n", sink.emitted);
 
     fclose(out);
+    if (segment_dir != NULL && rebuilt > 0 && write_manifest(segment_dir, segments) != 0) {
+        fprintf(stderr, "wn-cache: cannot write the manifest in %s\n", segment_dir);
+    }
+    if (sink.builder != NULL) {
+        int err = word_cache_write(sink.builder, bin_path, !truncated);
+        word_cache_builder_free(sink.builder);
+        if (err != 0) {
+            fprintf(stderr, "Failed to write %s\n", bin_path);
+            return 1;
+        }
+    }
+    free(lines.pool);
+    free(lines.start);
     return 0;
 }
@@ -0,0 +1,587 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "word_cache.h"
+
+#define CACHE_MAGIC 0x4243574e      /* "NWCB" */
+#define CACHE_VERSION 1
+#define CACHE_COMPLETE 1
+#define ENTRY_FIELDS 5              /* lemma, pos, synset, hypernyms, count */
+#define SYNSET_FIELDS 3             /* words, word count, gloss */
+#define MAX_VARIANTS 5
+
+struct cache_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t nentries;
+    uint32_t nbuckets;
+    uint32_t nsynsets;
+    uint32_t nrefs;
+    uint32_t strsize;
+    uint32_t datasize[NUMPARTS + 1];
+    uint32_t pad;
+};
+
+struct word_cache_builder {
+    char *strings;
+    uint32_t strsize;
+    uint32_t strcap;
+    uint32_t *strtab;           /* string offset + 1 by hash, 0 if free */
+    uint32_t strtabsize;
+    uint32_t nstrings;
+    uint32_t *synsets;
+    uint32_t nsynsets;
+    uint32_t syncap;
+    uint64_t *synkeys;          /* pos and offset by hash, 0 if free */
+    uint32_t *synvals;
+    uint32_t syntabsize;
+    uint32_t *refs;
+    uint32_t nrefs;
+    uint32_t refcap;
+    uint32_t *entries;
+    uint32_t nentries;
+    uint32_t entcap;
+    int failed;
+};
+
+static uint32_t hash_string(const char *text)
+{
+    uint32_t h = 2166136261U;
+
+    while (*text) {
+        h ^= (unsigned char)*text++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static uint32_t hash_key(const char *lemma, int pos)
+{
+    uint32_t h = hash_string(lemma);
+
+    h ^= (uint32_t)pos;
+    h *= 16777619U;
+    return h;
+}
+
+/* Size of the data file of each part of speech, identifying the
+ * database a cache was built from. */
+static void data_sizes(uint32_t *sizes)
+{
+    int pos;
+
+    sizes[0] = 0;
+    for (pos = 1; pos <= NUMPARTS; pos++) {
+        sizes[pos] = 0;
+        if (datafps[pos] != NULL && fseek(datafps[pos], 0L, SEEK_END) == 0) {
+            sizes[pos] = (uint32_t)ftell(datafps[pos]);
+        }
+    }
+}
+
+static int grow(void *ptr, uint32_t *cap, uint32_t need, size_t elem)
+{
+    void **p = ptr;
+    uint32_t size = *cap ? *cap : 1024;
+    void *q;
+
+    if (need <= *cap) {
+        return 0;
+    }
+    while (size < need) {
+        size *= 2;
+    }
+    if ((q = realloc(*p, (size_t)size * elem)) == NULL) {
+        return -1;
+    }
+    *p = q;
+    *cap = size;
+    return 0;
+}
+
+struct word_cache_builder *word_cache_builder_new(void)
+{
+    return calloc(1, sizeof(struct word_cache_builder));
+}
+
+void word_cache_builder_free(struct word_cache_builder *b)
+{
+    if (b == NULL) {
+        return;
+    }
+    free(b->strings);
+    free(b->strtab);
+    free(b->synsets);
+    free(b->synkeys);
+    free(b->synvals);
+    free(b->refs);
+    free(b->entries);
+    free(b);
+}
+
+static int rehash_strings(struct word_cache_builder *b)
+{
+    uint32_t size = b->strtabsize ? b->strtabsize * 2 : 65536;
+    uint32_t *tab = calloc(size, sizeof(uint32_t));
+    uint32_t i, h;
+
+    if (tab == NULL) {
+        return -1;
+    }
+    for (i = 0; i < b->strtabsize; i++) {
+        if (b->strtab[i] == 0) {
+            continue;
+        }
+        h = hash_string(b->strings + b->strtab[i] - 1) & (size - 1);
+        while (tab[h] != 0) {
+            h = (h + 1) & (size - 1);
+        }
+        tab[h] = b->strtab[i];
+    }
+    free(b->strtab);
+    b->strtab = tab;
+    b->strtabsize = size;
+    return 0;
+}
+
+/* Return the offset of text in the string pool, adding it once. */
+static uint32_t add_string(struct word_cache_builder *b, const char *text)
+{
+    uint32_t len = (uint32_t)strlen(text) + 1;
+    uint32_t h;
+
+    if ((b->nstrings + 1) * 2 > b->strtabsize && rehash_strings(b) != 0) {
+        b->failed = 1;
+        return WORD_CACHE_NONE;
+    }
+    h = hash_string(text) & (b->strtabsize - 1);
+    while (b->strtab[h] != 0) {
+        if (strcmp(b->strings + b->strtab[h] - 1, text) == 0) {
+            return b->strtab[h] - 1;
+        }
+        h = (h + 1) & (b->strtabsize - 1);
+    }
+    if (grow(&b->strings, &b->strcap, b->strsize + len, 1) != 0) {
+        b->failed = 1;
+        return WORD_CACHE_NONE;
+    }
+    memcpy(b->strings + b->strsize, text, len);
+    b->strtab[h] = b->strsize + 1;
+    b->nstrings++;
+    b->strsize += len;
+    return b->strtab[h] - 1;
+}
+
+static int rehash_synsets(struct word_cache_builder *b)
+{
+    uint32_t size = b->syntabsize ? b->syntabsize * 2 : 65536;
+    uint64_t *keys = calloc(size, sizeof(uint64_t));
+    uint32_t *vals = calloc(size, sizeof(uint32_t));
+    uint32_t i, h;
+
+    if (keys == NULL || vals == NULL) {
+        free(keys);
+        free(vals);
+        return -1;
+    }
+    for (i = 0; i < b->syntabsize; i++) {
+        if (b->synkeys[i] == 0) {
+            continue;
+        }
+        h = (uint32_t)(b->synkeys[i] * 0x9e3779b97f4a7c15ULL >> 32) & (size - 1);
+        while (keys[h] != 0) {
+            h = (h + 1) & (size - 1);
+        }
+        keys[h] = b->synkeys[i];
+        vals[h] = b->synvals[i];
+    }
+    free(b->synkeys);
+    free(b->synvals);
+    b->synkeys = keys;
+    b->synvals = vals;
+    b->syntabsize = size;
+    return 0;
+}
+
+/* Add the synset at offset in the data file of pos, once, and return
+ * its number. */
+uint32_t word_cache_add_synset(struct word_cache_builder *b, int pos, long offset,
+                               int wcount, const char **words, const char *gloss)
+{
+    uint64_t key = ((uint64_t)offset << 3) | (uint64_t)pos;
+    uint32_t h;
+    uint32_t *rec;
+    int i;
+
+    if ((b->nsynsets + 1) * 2 > b->syntabsize && rehash_synsets(b) != 0) {
+        b->failed = 1;
+        return WORD_CACHE_NONE;
+    }
+    h = (uint32_t)(key * 0x9e3779b97f4a7c15ULL >> 32) & (b->syntabsize - 1);
+    while (b->synkeys[h] != 0) {
+        if (b->synkeys[h] == key) {
+            return b->synvals[h];
+        }
+        h = (h + 1) & (b->syntabsize - 1);
+    }
+    if (grow(&b->synsets, &b->syncap, (b->nsynsets + 1) * SYNSET_FIELDS, sizeof(uint32_t)) != 0 ||
+        grow(&b->refs, &b->refcap, b->nrefs + wcount, sizeof(uint32_t)) != 0) {
+        b->failed = 1;
+        return WORD_CACHE_NONE;
+    }
+    rec = b->synsets + b->nsynsets * SYNSET_FIELDS;
+    rec[0] = b->nrefs;
+    rec[1] = (uint32_t)wcount;
+    for (i = 0; i < wcount; i++) {
+        b->refs[b->nrefs++] = add_string(b, words[i]);
+    }
+    rec[2] = gloss != NULL ? add_string(b, gloss) : WORD_CACHE_NONE;
+    b->synkeys[h] = key;
+    b->synvals[h] = b->nsynsets;
+    return b->nsynsets++;
+}
+
+void word_cache_add_entry(struct word_cache_builder *b, const char *lemma, int pos,
+                          uint32_t synset, const uint32_t *hypernyms, int hypernym_count)
+{
+    uint32_t *rec;
+    int i;
+
+    if (synset == WORD_CACHE_NONE) {
+        return;
+    }
+    if (grow(&b->entries, &b->entcap, (b->nentries + 1) * ENTRY_FIELDS, sizeof(uint32_t)) != 0 ||
+        grow(&b->refs, &b->refcap, b->nrefs + hypernym_count, sizeof(uint32_t)) != 0) {
+        b->failed = 1;
+        return;
+    }
+    rec = b->entries + b->nentries * ENTRY_FIELDS;
+    rec[0] = add_string(b, lemma);
+    rec[1] = (uint32_t)pos;
+    rec[2] = synset;
+    rec[3] = b->nrefs;
+    rec[4] = (uint32_t)hypernym_count;
+    for (i = 0; i < hypernym_count; i++) {
+        b->refs[b->nrefs++] = hypernyms[i];
+    }
+    b->nentries++;
+}
+
+/* Write the cache to path.  complete says whether every index entry
+ * was added.  Returns 0, or -1 if it couldn't be written. */
+int word_cache_write(struct word_cache_builder *b, const char *path, int complete)
+{
+    struct cache_header h;
+    uint32_t *buckets;
+    uint32_t i, k;
+    FILE *fp;
+    int err = 0;
+
+    if (b->failed) {
+        return -1;
+    }
+    memset(&h, 0, sizeof(h));
+    h.magic = CACHE_MAGIC;
+    h.version = CACHE_VERSION;
+    h.flags = complete ? CACHE_COMPLETE : 0;
+    h.nentries = b->nentries;
+    h.nsynsets = b->nsynsets;
+    h.nrefs = b->nrefs;
+    h.strsize = b->strsize;
+    data_sizes(h.datasize);
+    h.nbuckets = 16;
+    while (h.nbuckets < b->nentries * 2) {
+        h.nbuckets *= 2;
+    }
+    if ((buckets = calloc(h.nbuckets, sizeof(uint32_t))) == NULL) {
+        return -1;
+    }
+
+    /* A lemma is in an index file once, so keys are unique */
+    for (i = 0; i < b->nentries; i++) {
+        const uint32_t *rec = b->entries + i * ENTRY_FIELDS;
+        k = hash_key(b->strings + rec[0], (int)rec[1]) & (h.nbuckets - 1);
+        while (buckets[k] != 0) {
+            k = (k + 1) & (h.nbuckets - 1);
+        }
+        buckets[k] = i + 1;
+    }
+
+    if ((fp = fopen(path, "wb")) == NULL) {
+        free(buckets);
+        return -1;
+    }
+    if (fwrite(&h, sizeof(h), 1, fp) != 1 ||
+        fwrite(buckets, sizeof(uint32_t), h.nbuckets, fp) != h.nbuckets ||
+        fwrite(b->entries, sizeof(uint32_t), (size_t)h.nentries * ENTRY_FIELDS, fp) !=
+            (size_t)h.nentries * ENTRY_FIELDS ||
+        fwrite(b->synsets, sizeof(uint32_t), (size_t)h.nsynsets * SYNSET_FIELDS, fp) !=
+            (size_t)h.nsynsets * SYNSET_FIELDS ||
+        fwrite(b->refs, sizeof(uint32_t), h.nrefs, fp) != h.nrefs ||
+        fwrite(b->strings, 1, h.strsize, fp) != h.strsize) {
+        err = -1;
+    }
+    if (fclose(fp) != 0) {
+        err = -1;
+    }
+    free(buckets);
+    return err;
+}
+
+/* Load the cache in path, by mapping it into memory where possible.
+ * Returns 0, or -1 if there is no cache or it was built from other
+ * data files, in which case words are looked up in the database. */
+int word_cache_load(struct word_cache *cache, const char *path)
+{
+    const struct cache_header *fh;
+    uint32_t sizes[NUMPARTS + 1];
+    size_t need;
+    long size;
+    FILE *fp;
+
+    memset(cache, 0, sizeof(*cache));
+    if ((fp = fopen(path, "rb")) == NULL) {
+        return -1;
+    }
+    if (wn_map_file(fp) == 0 && (cache->base = wn_mapped(fp, &size)) != NULL) {
+        cache->fp = fp;
+    } else {
+        wn_unmap_file(fp); /* mapped but unusable, e.g. WNLEGACY */
+        fseek(fp, 0L, SEEK_END);
+        size = ftell(fp);
+        rewind(fp);
+        if (size <= 0 || (cache->buf = malloc(size)) == NULL ||
+            fread(cache->buf, 1, size, fp) != (size_t)size) {
+            free(cache->buf);
+            cache->buf = NULL;
+            fclose(fp);
+            return -1;
+        }
+        fclose(fp);
+        cache->base = cache->buf;
+    }
+
+    fh = (const struct cache_header *)cache->base;
+    data_sizes(sizes);
+    need = sizeof(*fh);
+    if ((size_t)size >= need) {
+        need += ((size_t)fh->nbuckets + (size_t)fh->nentries * ENTRY_FIELDS +
+                 (size_t)fh->nsynsets * SYNSET_FIELDS + fh->nrefs) * sizeof(uint32_t) +
+                fh->strsize;
+    }
+    if ((size_t)size < sizeof(*fh) || fh->magic != CACHE_MAGIC ||
+        fh->version != CACHE_VERSION || (size_t)size != need ||
+        fh->nbuckets == 0 || (fh->nbuckets & (fh->nbuckets - 1)) != 0 ||
+        memcmp(fh->datasize, sizes, sizeof(sizes)) != 0) {
+        fprintf(stderr, "%s is not a word cache for this database, not using it\n", path);
+        word_cache_close(cache);
+        return -1;
+    }
+    cache->buckets = (const uint32_t *)(fh + 1);
+    cache->entries = cache->buckets + fh->nbuckets;
+    cache->synsets = cache->entries + (size_t)fh->nentries * ENTRY_FIELDS;
+    cache->refs = cache->synsets + (size_t)fh->nsynsets * SYNSET_FIELDS;
+    cache->strings = (const char *)(cache->refs + fh->nrefs);
+    cache->nbuckets = fh->nbuckets;
+    cache->complete = (fh->flags & CACHE_COMPLETE) != 0;
+    return 0;
+}
+
+void word_cache_close(struct word_cache *cache)
+{
+    if (cache->fp != NULL) {
+        wn_unmap_file(cache->fp);
+        fclose(cache->fp);
+    }
+    free(cache->buf);
+    memset(cache, 0, sizeof(*cache));
+}
+
+/* Return the entry record for lemma in pos, or NULL. */
+static const uint32_t *find_entry(const struct word_cache *cache, const char *lemma, int pos)
+{
+    uint32_t k = hash_key(lemma, pos) & (cache->nbuckets - 1);
+    const uint32_t *rec;
+
+    while (cache->buckets[k] != 0) {
+        rec = cache->entries + (size_t)(cache->buckets[k] - 1) * ENTRY_FIELDS;
+        if (rec[1] == (uint32_t)pos && strcmp(cache->strings + rec[0], lemma) == 0) {
+            return rec;
+        }
+        k = (k + 1) & (cache->nbuckets - 1);
+    }
+    return NULL;
+}
+
+/* Find word in the cache under the spellings getindex() tries, in the
+ * same order.  Returns 1 if found, 0 if it isn't in WordNet, or -1 if
+ * the cache doesn't cover every entry and it may be. */
+static int cache_lookup(const struct word_cache *cache, const char *word, int pos,
+                        struct word_sense *sense)
+{
+    char strings[MAX_VARIANTS][WORDBUF];
+    const uint32_t *rec = NULL;
+    int i, j, k;
+    char c;
+
+    for (i = 0; i < MAX_VARIANTS; i++) {
+        snprintf(strings[i], WORDBUF, "%s", word);
+        strtolower(strings[i]);
+    }
+    strsubst(strings[1], '_', '-');
+    strsubst(strings[2], '-', '_');
+    for (i = j = k = 0; (c = strings[0][i]) != '\0'; i++) {
+        if (c != '_' && c != '-') {
+            strings[3][j++] = c;
+        }
+        if (c != '.') {
+            strings[4][k++] = c;
+        }
+    }
+    strings[3][j] = '\0';
+    strings[4][k] = '\0';
+
+    for (i = 0; i < MAX_VARIANTS && rec == NULL; i++) {
+        if (strings[i][0] != '\0' && (i == 0 || strcmp(strings[0], strings[i]) != 0)) {
+            rec = find_entry(cache, strings[i], pos);
+        }
+    }
+    if (rec == NULL) {
+        return cache->complete ? 0 : -1;
+    }
+    sense->cache = cache;
+    sense->synset = rec[2];
+    sense->hypernyms = cache->refs + rec[3];
+    sense->hypernym_count = (int)rec[4];
+    return 1;
+}
+
+/* Return 1 if word is in WordNet in pos, or 0, from the cache if it
+ * covers the word. */
+int word_cache_contains(const struct word_cache *cache, const char *word, int pos)
+{
+    struct word_sense sense;
+    char buf[WORDBUF];
+    IndexPtr idx;
+    int found;
+
+    if (cache != NULL && cache->base != NULL &&
+        (found = cache_lookup(cache, word, pos, &sense)) >= 0) {
+        return found;
+    }
+    snprintf(buf, sizeof(buf), "%s", word);
+    idx = getindex(buf, pos);
+    found = idx != NULL && idx->off_cnt > 0;
+    if (idx != NULL) {
+        free_index(idx);
+    }
+    return found;
+}
+
+/* Look up the first sense of word in pos, and its hypernyms, in the
+ * cache if it covers the word, or else the database.  Returns 1, or 0
+ * if word isn't in WordNet in pos or its synset can't be read. */
+int word_sense_lookup(const struct word_cache *cache, const char *word, int pos,
+                      struct word_sense *sense)
+{
+    char buf[WORDBUF];
+    IndexPtr idx;
+    int found, i, n = 0;
+
+    memset(sense, 0, sizeof(*sense));
+    if (cache != NULL && cache->base != NULL &&
+        (found = cache_lookup(cache, word, pos, sense)) >= 0) {
+        return found;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", word);
+    idx = getindex(buf, pos);
+    if (idx == NULL || idx->off_cnt == 0) {
+        if (idx != NULL) {
+            free_index(idx);
+        }
+        return 0;
+    }
+    snprintf(buf, sizeof(buf), "%s", word);
+    sense->syn = read_synset(pos, idx->offset[0], buf);
+    free_index(idx);
+    if (sense->syn == NULL) {
+        return 0;
+    }
+    for (i = 0; i < sense->syn->ptrcount; i++) {
+        if (sense->syn->ptrtyp[i] == HYPERPTR && sense->syn->ppos[i] != 0) {
+            n++;
+        }
+    }
+    if (n > 0 && (sense->hyper_syns = malloc(n * sizeof(SynsetPtr))) != NULL) {
+        for (i = 0; i < sense->syn->ptrcount; i++) {
+            SynsetPtr hyper;
+
+            if (sense->syn->ptrtyp[i] != HYPERPTR || sense->syn->ppos[i] == 0) {
+                continue;
+            }
+            hyper = read_synset(sense->syn->ppos[i], sense->syn->ptroff[i], buf);
+            if (hyper != NULL) {
+                sense->hyper_syns[sense->hypernym_count++] = hyper;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Return the synset record of the sense, or of hypernym h if h >= 0 */
+static const uint32_t *cached_synset(const struct word_sense *sense, int h)
+{
+    uint32_t id = h < 0 ? sense->synset : sense->hypernyms[h];
+
+    return sense->cache->synsets + (size_t)id * SYNSET_FIELDS;
+}
+
+/* Number of words in the sense, or in hypernym h if h >= 0 */
+int word_sense_count(const struct word_sense *sense, int h)
+{
+    SynsetPtr syn;
+
+    if (sense->cache != NULL) {
+        return (int)cached_synset(sense, h)[1];
+    }
+    syn = h < 0 ? sense->syn : sense->hyper_syns[h];
+    return syn != NULL ? syn->wcount : 0;
+}
+
+const char *word_sense_word(const struct word_sense *sense, int h, int i)
+{
+    if (sense->cache != NULL) {
+        const uint32_t *rec = cached_synset(sense, h);
+        return sense->cache->strings + sense->cache->refs[rec[0] + i];
+    }
+    return h < 0 ? sense->syn->words[i] : sense->hyper_syns[h]->words[i];
+}
+
+/* Gloss of the sense, or of hypernym h if h >= 0, or NULL */
+const char *word_sense_gloss(const struct word_sense *sense, int h)
+{
+    SynsetPtr syn;
+
+    if (sense->cache != NULL) {
+        const uint32_t *rec = cached_synset(sense, h);
+        return rec[2] != WORD_CACHE_NONE ? sense->cache->strings + rec[2] : NULL;
+    }
+    syn = h < 0 ? sense->syn : sense->hyper_syns[h];
+    return syn != NULL ? syn->defn : NULL;
+}
+
+void word_sense_free(struct word_sense *sense)
+{
+    int i;
+
+    for (i = 0; i < sense->hypernym_count && sense->hyper_syns != NULL; i++) {
+        free_synset(sense->hyper_syns[i]);
+    }
+    free(sense->hyper_syns);
+    if (sense->syn != NULL) {
+        free_synset(sense->syn);
+    }
+    memset(sense, 0, sizeof(*sense));
+}
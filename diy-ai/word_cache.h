@@ -0,0 +1,69 @@
+#ifndef DIY_AI_WORD_CACHE_H
+#define DIY_AI_WORD_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <wn.h>
+
+/*
+ * Binary word cache written by wn-cache and read by wn-chat and
+ * wn-meaning.  For each index entry it holds the first sense of the
+ * lemma and the hypernyms of that sense, so looking a word up needs no
+ * access to the WordNet files.  The file is a header, a hash table of
+ * (lemma, part of speech) keys, entry and synset records, a list of
+ * offsets that synsets and entries refer into, and a string pool.
+ */
+
+#define WORD_CACHE_FILE "word_cache.bin"
+#define WORD_CACHE_NONE 0xffffffffU
+
+struct word_cache {
+    FILE *fp;                   /* file mapped, or NULL */
+    char *buf;                  /* file read in, if it couldn't be mapped */
+    const char *base;
+    const uint32_t *buckets;
+    const uint32_t *entries;
+    const uint32_t *synsets;
+    const uint32_t *refs;
+    const char *strings;
+    uint32_t nbuckets;
+    int complete;               /* every index entry is in the cache */
+};
+
+/* First sense of a word in one part of speech, from the cache or read
+ * from the database. */
+struct word_sense {
+    const struct word_cache *cache;
+    uint32_t synset;
+    const uint32_t *hypernyms;
+    int hypernym_count;
+    SynsetPtr syn;
+    SynsetPtr *hyper_syns;
+};
+
+struct word_cache_builder;
+
+int word_cache_load(struct word_cache *cache, const char *path);
+void word_cache_close(struct word_cache *cache);
+
+int word_cache_contains(const struct word_cache *cache, const char *word, int pos);
+
+/* The sense itself is hypernym -1, and its hypernyms 0 up to
+ * hypernym_count - 1. */
+int word_sense_lookup(const struct word_cache *cache, const char *word, int pos,
+                      struct word_sense *sense);
+int word_sense_count(const struct word_sense *sense, int hypernym);
+const char *word_sense_word(const struct word_sense *sense, int hypernym, int i);
+const char *word_sense_gloss(const struct word_sense *sense, int hypernym);
+void word_sense_free(struct word_sense *sense);
+
+struct word_cache_builder *word_cache_builder_new(void);
+uint32_t word_cache_add_synset(struct word_cache_builder *b, int pos, long offset,
+                               int wcount, const char **words, const char *gloss);
+void word_cache_add_entry(struct word_cache_builder *b, const char *lemma, int pos,
+                          uint32_t synset, const uint32_t *hypernyms, int hypernym_count);
+int word_cache_write(struct word_cache_builder *b, const char *path, int complete);
+void word_cache_builder_free(struct word_cache_builder *b);
+
+#endif
@@ -26,6 +26,7 @@
 #define VRBSENTFILE  	"%s\\sents.vrb"
 #define VRBIDXFILE	"%s\\sentidx.vrb"
 #define CNTLISTFILE     "%s\\cntlist.rev"
+#define ICFILE		"%s\\ic.dat"
 #else
 #define DICTDIR         "/dict"
 #ifndef DEFAULTPATH
@@ -39,6 +40,7 @@
 #define VRBSENTFILE     "%s/sents.vrb"
 #define VRBIDXFILE	"%s/sentidx.vrb"
 #define CNTLISTFILE     "%s/cntlist.rev"
+#define ICFILE		"%s/ic.dat"
 #endif
 
 /* Various buffer sizes */
@@ -236,6 +238,61 @@ typedef struct {
 
 typedef SearchResults *SearchResultsPtr;
 
+/* Synset id, numbering the synsets of all parts of speech from 0 in
+   the in-memory pointer graph */
+
+typedef unsigned int WnId;
+
+#define WN_NOID		0xffffffffU	/* no such synset */
+
+/* Similarity measures for wn_similarity() */
+
+#define WN_SIM_PATH	1	/* inverse of shortest path length */
+#define WN_SIM_WUP	2	/* Wu-Palmer */
+#define WN_SIM_LCH	3	/* Leacock-Chodorow */
+#define WN_SIM_RES	4	/* Resnik, needs information content */
+#define WN_SIM_LIN	5	/* Lin, needs information content */
+#define WN_SIM_JCN	6	/* Jiang-Conrath, needs information content */
+
+/* Pointer in the in-memory pointer graph, to its target synset or
+   from its source synset */
+
+typedef struct {
+    WnId id;			/* id of other synset, WN_NOID if unknown */
+    int ptrtyp;			/* pointer type */
+    int pos;			/* part of speech of other synset */
+    long offset;		/* offset of other synset, -1 if unknown */
+    int pfrm;			/* 'from' word number, 0 for synset */
+    int pto;			/* 'to' word number, 0 for synset */
+} WnEdge;
+
+/* Lemma derivationally related to a sense of a word */
+
+typedef struct {
+    const char *lemma;		/* related lemma, kept by the library */
+    int pos;			/* its part of speech */
+    int sense;			/* its sense number */
+    int frompos;		/* part of speech of the word's sense */
+    int fromsense;		/* sense number of the word */
+} WnDeriv;
+
+/* Library counters, kept in total and for the current query (the most
+   recent call to findtheinfo() or findtheinfo_ds()) */
+
+typedef struct {
+    unsigned long binsearches;	/* calls to bin_search() */
+    unsigned long probes;	/* lines examined by bin_search() */
+    unsigned long bytesread;	/* bytes read from database files */
+    unsigned long indexparsed;	/* index entries parsed */
+    unsigned long synsetsparsed; /* synsets parsed */
+    unsigned long cachehits;	/* lookups answered from a library cache */
+    unsigned long cachemisses;	/* cache lookups that went to the files */
+    unsigned long allocs;	/* memory allocations */
+} WNStats;
+
+#define WNSTATS_TOTAL	0	/* pass to wn_stats() for running totals */
+#define WNSTATS_QUERY	1	/* pass to wn_stats() for current query */
+
 /* Global variables and flags */
 
 extern SearchResults wnresults;	/* structure containing results of search */
@@ -247,6 +304,38 @@ extern int frflag;		/* if set, print verb frames after synset */
 extern int abortsearch;		/* if set, stop search algorithm */
 extern int offsetflag;		/* if set, print byte offset of each synset */
 extern int wnsnsflag;		/* if set, print WN sense # for each word */
+extern int legacyflag;		/* if set, use only the original stdio
+				   search code, no in-memory access */
+
+/* Counters are only maintained if the library is built with WN_STATS.
+   Otherwise WNSTAT() compiles to nothing. */
+
+#ifdef WN_STATS
+extern WNStats wnstats[2];
+#define WNSTAT(field, n) \
+    (wnstats[WNSTATS_TOTAL].field += (n), wnstats[WNSTATS_QUERY].field += (n))
+#else
+#define WNSTAT(field, n) ((void)0)
+#endif
+
+/* Trace spans are only recorded if the library is built with WN_TRACE
+   and tracing has been started with wn_trace_start() or the WNTRACE
+   environment variable.  WNTRACE_BEGIN() declares span, so it must
+   appear where a declaration may. */
+
+#ifdef WN_TRACE
+extern int wntracing;
+extern double wn_trace_now(void);
+extern void wn_trace_span(const char *, double);
+extern void wn_trace_env(void);
+#define WNTRACE_BEGIN(span) \
+    double span = wntracing ? wn_trace_now() : -1.0
+#define WNTRACE_END(span, name) \
+    do { if (span >= 0.0 && wntracing) wn_trace_span(name, span); } while (0)
+#else
+#define WNTRACE_BEGIN(span)
+#define WNTRACE_END(span, name) ((void)0)
+#endif
 
 /* File pointers for database files */
 
@@ -286,6 +375,15 @@ extern char *findtheinfo(char *, int, int, int);
 /* Primary search algorithm for use with programs (returns data structure) */
 extern SynsetPtr findtheinfo_ds(char *, int, int, int); 
 
+/* Overview of word and its base forms in all parts of speech, each
+   with a header line, in one buffer */
+extern char *wn_overview(char *);
+
+/* Several searches of word and its base forms in one part of speech,
+   looking each form up once, with output passed to a function */
+extern int wn_searches(char *, int, int *, int, int,
+		       int (*)(int, char *, char *, void *), void *);
+
 /* Set bit for each search type that is valid for the search word
    passed and return bit mask. */
 extern unsigned int is_defined(char *, int); 
@@ -328,6 +426,12 @@ SynsetPtr traceptrs_ds(SynsetPtr, int, int, int);
 /* Do requested search on synset passed, returning output in buffer. */
 extern char *do_trace(SynsetPtr, int, int, int);
 
+/* Copy a synset */
+extern SynsetPtr copy_synset(SynsetPtr);
+
+/* Discard results cached by the search code.  Called by re_wninit(). */
+extern void wn_flush_caches(void);
+
 /*** Morphology functions (morph.c) ***/
 
 /* Open exception list files */
@@ -417,6 +521,9 @@ char *SetSearchdir();
 /* Return number of times sense is tagged */
 int GetTagcnt(IndexPtr, int);
 
+/* As GetTagcnt(), for the sense in a synset already read */
+int GetSynsetTagcnt(IndexPtr, SynsetPtr);
+
 /*
 ** Wrapper functions for strstr that allow you to retrieve each
 ** occurance of a word within a longer string, not just the first.
@@ -430,6 +537,148 @@ int GetTagcnt(IndexPtr, int);
 extern void strstr_init (char *, char *);
 extern int strstr_getnext (void);
 
+/*** Statistics functions (wnstats.c) ***/
+
+/* Return counters selected by WNSTATS_TOTAL or WNSTATS_QUERY, or NULL
+   if the library was built without WN_STATS. */
+extern WNStats *wn_stats(int);
+
+/* Zero the selected counters */
+extern void wn_stats_reset(int);
+
+/*** Trace functions (wntrace.c) ***/
+
+/* Start recording trace spans, to be written to file in Chrome trace
+   event format.  Returns 0, or -1 if not built with WN_TRACE. */
+extern int wn_trace_start(const char *);
+
+/* Stop recording and write the trace file.  Returns 0 on success. */
+extern int wn_trace_stop(void);
+
+/*** In-memory database files (wnmmap.c) ***/
+
+/* Map open database file into memory.  Returns 0, or -1 if it can't
+   be mapped and will be read through stdio. */
+extern int wn_map_file(FILE *);
+
+/* Remove mapping of file before closing it */
+extern void wn_unmap_file(FILE *);
+
+/* Return mapping of file and store its size, or NULL if the file
+   isn't mapped or legacyflag is set. */
+extern char *wn_mapped(FILE *, long *);
+
+/* Copy line at offset in mapped file into buffer as fgets() would.
+   Returns 1, 0 at end of file, or -1 if the file isn't mapped. */
+extern int wn_map_line(FILE *, long, char *, int);
+
+/*** In-memory pointer graph (wngraph.c) ***/
+
+/* Load the pointers of all synsets into memory.  Returns 0, or -1 if
+   the data files aren't mapped or legacyflag is set. */
+extern int wn_graph_load(void);
+
+/* Return 1 if the graph is loaded, loading it once enough searches
+   have been made that use it. */
+extern int wn_graph_ready(void);
+
+/* Free the graph */
+extern void wn_graph_free(void);
+
+/* Store up to max pointers of type (any type if 0) from synset at
+   pos and offset into edges.  Returns the number of such pointers,
+   or -1 if the graph isn't loaded or the synset isn't in it. */
+extern int wn_graph_ptrs(int, long, int, WnEdge *, int);
+
+/* As wn_graph_ptrs(), for pointers to the synset from others */
+extern int wn_graph_refs(int, long, int, WnEdge *, int);
+
+/* Return number of synset ids, or 0 if the graph isn't loaded */
+extern long wn_synset_count(void);
+
+/* Return id of synset at pos and offset, or WN_NOID */
+extern WnId wn_synset_id(int, long);
+
+/* Return part of speech (0 if none) and offset (-1 if none) of id */
+extern int wn_id_pos(WnId);
+extern long wn_id_offset(WnId);
+
+/* As wn_graph_ptrs() and wn_graph_refs(), for synset id */
+extern int wn_id_ptrs(WnId, int, WnEdge *, int);
+extern int wn_id_refs(WnId, int, WnEdge *, int);
+
+/* Return 1 if first synset is second, or below it through hypernym
+   and instance pointers, 0 if not, or -1 if the graph isn't loaded */
+extern int wn_is_a(WnId, WnId);
+
+/* Return fewest hypernym and instance pointers from synset to the top
+   of its hierarchy, or -1 */
+extern int wn_depth(WnId);
+
+/* Return greatest depth of any synset in part of speech, or -1 */
+extern int wn_max_depth(int);
+
+/* Store up to max tops of the hierarchies above synset in array, and
+   return how many there are, or -1 */
+extern int wn_roots(WnId, WnId *, int);
+
+/* Call function with each synset below synset through hypernym and
+   instance pointers, and argument, until it returns non-zero.  Returns
+   number of synsets passed to function, or -1. */
+extern int wn_descendants(WnId, int (*)(WnId, void *), void *);
+
+/* Find a shortest path from first synset to second through pointers
+   whose types are set in mask (1 << ptrtyp), or of any type if mask is
+   0, of at most the length given if it is positive.  Stores up to max
+   of its pointers in edges, in order, and returns its length, or -1 if
+   there is none. */
+extern int wn_path(WnId, WnId, unsigned long long, int, WnEdge *, int);
+
+/* Used by hierarchical holonym and meronym searches */
+extern int wn_graph_holomero(long, int);
+extern int wn_graph_inherited(long, int, int, long *, int *);
+
+/*** Semantic similarity (wnsim.c) ***/
+
+/* Return similarity of two synsets by measure, or -1 if undefined */
+extern double wn_similarity(WnId, WnId, int);
+
+/* Return lowest common subsumer of two synsets, or WN_NOID */
+extern WnId wn_lcs(WnId, WnId);
+
+/* Store similarity by measure of each row synset to each column synset
+   in array, row by row, using up to the number of threads given.
+   Returns 0, or -1 on error. */
+extern int wn_similarity_matrix(WnId *, int, WnId *, int, int, double *, int);
+
+/*** Information content (wnic.c) ***/
+
+/* Build information content of every synset from the tag counts in
+   cntlist.rev and write it to file, or ic.dat in the database
+   directory if NULL.  Returns 0, or -1 on error. */
+extern int wn_ic_build(const char *);
+
+/* Load information content from file, or ic.dat in the database
+   directory if NULL.  Returns 0, or -1 if it can't be read or was
+   built from another database. */
+extern int wn_ic_load(const char *);
+
+/* Free the information content table */
+extern void wn_ic_free(void);
+
+/* Return information content of synset, or -1 if none is loaded */
+extern double wn_ic(WnId);
+
+/*** Derivational morphology (wnderiv.c) ***/
+
+/* Store up to max lemmas derivationally related to senses of word, in
+   any part of speech, in array.  Returns the number there are, or -1
+   if the derivation pointers can't be loaded. */
+extern int wn_derivations(const char *, WnDeriv *, int);
+
+/* Free the derivation links, and the lemmas wn_derivations() returned */
+extern void wn_derivations_free(void);
+
 /*** Binary search functions (binsearch.c) ***/
 
 /* General purpose binary search function to search for key as first
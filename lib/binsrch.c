@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include "wn.h"
 
 static char *Id = "$Id: binsrch.c,v 1.15 2005/02/01 16:46:43 wn Rel $";
 
@@ -30,21 +31,83 @@ char *read_index(long offset, FILE *fp) {
     linep = line;
     line[0] = '0';
 
-    fseek( fp, offset, SEEK_SET );
-    fgets(linep, LINE_LEN, fp);
+    if (wn_map_line(fp, offset, linep, LINE_LEN) < 0) {
+	fseek( fp, offset, SEEK_SET );
+	fgets(linep, LINE_LEN, fp);
+	WNSTAT(bytesread, strlen(line));
+    }
     return(line);
 }
 
+/* Same search as bin_search() over a file mapped into memory.  File
+   positions are emulated exactly so the same lines are probed and
+   last_bin_search_offset is set the same way. */
+
+static char *mem_bin_search(const char *searchkey, char *base, long size)
+{
+    long top, mid, bot, diff, pos, len;
+    char *linep, *nl, key[KEY_LEN];
+    int length;
+
+    diff=666;
+    linep = line;
+    line[0] = '\0';
+    WNSTAT(binsearches, 1);
+
+    top = 0;
+    bot = size;
+    mid = (bot - top) / 2;
+
+    do {
+	pos = mid > 0 ? mid - 1 : 0;
+	if(mid != 1)
+	    while(pos < size && base[pos++] != '\n')
+		WNSTAT(bytesread, 1);
+	last_bin_search_offset = pos;
+	if (pos < size) {	/* as fgets() - copy through newline */
+	    len = size - pos < LINE_LEN - 1 ? size - pos : LINE_LEN - 1;
+	    if ((nl = memchr(base + pos, '\n', len)) != NULL)
+		len = nl - (base + pos) + 1;
+	    memcpy(linep, base + pos, len);
+	    linep[len] = '\0';
+	}
+	WNSTAT(probes, 1);
+	WNSTAT(bytesread, strlen(linep));
+	length = (int)(strchr(linep, ' ') - linep);
+	strncpy(key, linep, length);
+	key[length] = '\0';
+	if(strcmp(key, searchkey) < 0) {
+	    top = mid;
+	    diff = (bot - top) / 2;
+	    mid = top + diff;
+	}
+	if(strcmp(key, searchkey) > 0) {
+	    bot = mid;
+	    diff = (bot - top) / 2;
+	    mid = top + diff;
+	}
+    } while((strcmp(key, searchkey)) && (diff != 0));
+    
+    if(!strcmp(key, searchkey))
+	return(line);
+    else
+	return(NULL);
+}
+
 char *bin_search(const char *searchkey, FILE *fp)
 {
     int c;
     long top, mid, bot, diff;
-    char *linep, key[KEY_LEN];
+    char *linep, key[KEY_LEN], *base;
     int length;
 
+    if ((base = wn_mapped(fp, &top)) != NULL)
+	return(mem_bin_search(searchkey, base, top));
+
     diff=666;
     linep = line;
     line[0] = '\0';
+    WNSTAT(binsearches, 1);
 
     fseek(fp, 0L, 2);
     top = 0;
@@ -54,9 +117,12 @@ char *bin_search(const char *searchkey, FILE *fp)
     do {
 	fseek(fp, mid - 1, 0);
 	if(mid != 1)
-	    while((c = getc(fp)) != '\n' && c != EOF);
+	    while((c = getc(fp)) != '\n' && c != EOF)
+		WNSTAT(bytesread, 1);
         last_bin_search_offset = ftell( fp );
 	fgets(linep, LINE_LEN, fp);
+	WNSTAT(probes, 1);
+	WNSTAT(bytesread, strlen(linep));
 	length = (int)(strchr(linep, ' ') - linep);
 	strncpy(key, linep, length);
 	key[length] = '\0';
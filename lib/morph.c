@@ -76,6 +76,7 @@ static char *wordbase(char *, int);
 static int hasprep(char *, int);
 static char *exc_lookup(char *, int);
 static char *morphprep(char *);
+static char *do_morphstr(char *, int);
 
 static void append_str(char *buf, size_t size, const char *src)
 {
@@ -112,6 +113,7 @@ int re_morphinit(void)
 
     for (i = 1; i <= NUMPARTS; i++) {
 	if (exc_fps[i] != NULL) {
+	    wn_unmap_file(exc_fps[i]);
 	    fclose(exc_fps[i]); exc_fps[i] = NULL;
 	}
     }
@@ -180,7 +182,8 @@ static int do_init(void)
 		    fname);
 	    display_message(msgbuf);
 	    openerr = -1;
-	}
+	} else
+	    wn_map_file(exc_fps[i]);
     }
     return(openerr);
 }
@@ -190,6 +193,16 @@ static int do_init(void)
    with NULL argument return additional baseforms for original string. */
 
 char *morphstr(char *origstr, int pos)
+{
+    char *baseform;
+    WNTRACE_BEGIN(span);
+
+    baseform = do_morphstr(origstr, pos);
+    WNTRACE_END(span, "morphstr");
+    return(baseform);
+}
+
+static char *do_morphstr(char *origstr, int pos)
 {
     static char searchstr[WORDBUF], str[WORDBUF];
     static int svcnt, svprep;
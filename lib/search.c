@@ -53,6 +53,8 @@ static void printsynset(char *, SynsetPtr, char *, int, int, int, int);
 static void printantsynset(SynsetPtr, char *, int, int);
 static char *printant(int, SynsetPtr, int, char *, char *);
 static void printbuffer(char *);
+static void printbytes(char *, long);
+static void truncbuffer(long);
 static void printsns(SynsetPtr, int);
 static void printsense(SynsetPtr, int);
 static void catword(char *, SynsetPtr, int, int, int);
@@ -62,21 +64,30 @@ static int HasHoloMero(IndexPtr, int);
 static int HasPtr(SynsetPtr, int);
 static int getsearchsense(SynsetPtr, int);
 static int depthcheck(int, SynsetPtr);
+static void cycle_error(SynsetPtr);
+static void traceptrs(SynsetPtr, int, int, int);
+static void traceptrs_r(SynsetPtr, int, int, int);
+static void tracecoords_r(SynsetPtr, int, int, int);
+static void traceinherit_r(SynsetPtr, int, int, int);
+static SynsetPtr traceptrs_ds_r(SynsetPtr, int, int, int);
 static void interface_doevents();
 static void getexample(char *, char *);
 static int findexample(SynsetPtr);
+static SynsetPtr do_parse_synset(long, int, char *);
 
 /* Static variables */
 
 static int prflag, sense, prlexid;
 static int overflag = 0;	/* set when output buffer overflows */
 static char searchbuffer[SEARCHBUF];
+static long searchlen;		/* strlen(searchbuffer) */
 static int lastholomero;	/* keep track of last holo/meronym printed */
 #define TMPBUFSIZE 1024*10
 static char tmpbuf[TMPBUFSIZE];	/* general purpose printing buffer */
 static char wdbuf[WORDBUF];	/* general purpose word buffer */
 static char msgbuf[256];	/* buffer for constructing error messages */
 static int adj_marker;
+static char synline[LINEBUF];	/* synset line being parsed */
 
 extern long last_bin_search_offset;
 
@@ -121,9 +132,13 @@ IndexPtr index_lookup(char *word, int dbase)
 	return(NULL);
     }
 
-    if ((line = bin_search(word, fp)) != NULL) {
-	idx = parse_index( last_bin_search_offset, dbase, line);
-    } 
+    {
+	WNTRACE_BEGIN(span);
+	if ((line = bin_search(word, fp)) != NULL) {
+	    idx = parse_index( last_bin_search_offset, dbase, line);
+	} 
+	WNTRACE_END(span, "index_lookup");
+    }
     return (idx);
 }
 
@@ -146,6 +161,8 @@ IndexPtr parse_index(long offset, int dbase, char *line) {
     
     idx = (IndexPtr)malloc(sizeof(Index));
     assert(idx);
+    WNSTAT(indexparsed, 1);
+    WNSTAT(allocs, 1);
 
     /* set offset of entry in index file */
     idx->idxoffset = offset;
@@ -164,12 +181,14 @@ IndexPtr parse_index(long offset, int dbase, char *line) {
     
     idx->wd = malloc(strlen(ptrtok) + 1);
     assert(idx->wd);
+    WNSTAT(allocs, 1);
     snprintf(idx->wd, strlen(ptrtok) + 1, "%s", ptrtok);
     
     /* get the part of speech */
     ptrtok=strtok(NULL," \n");
     idx->pos = malloc(strlen(ptrtok) + 1);
     assert(idx->pos);
+    WNSTAT(allocs, 1);
     snprintf(idx->pos, strlen(ptrtok) + 1, "%s", ptrtok);
     
     /* get the collins count */
@@ -183,6 +202,7 @@ IndexPtr parse_index(long offset, int dbase, char *line) {
     if (idx->ptruse_cnt) {
 	idx->ptruse = (int *) malloc(idx->ptruse_cnt * (sizeof(int)));
 	assert(idx->ptruse);
+	WNSTAT(allocs, 1);
 	
 	/* get the pointers types */
 	for(j=0;j < idx->ptruse_cnt; j++) {
@@ -202,6 +222,7 @@ IndexPtr parse_index(long offset, int dbase, char *line) {
     /* make space for the offsets */
     idx->offset = (unsigned long *) malloc(idx->off_cnt * sizeof(*idx->offset));
     assert(idx->offset);
+    WNSTAT(allocs, 1);
     
     /* get the offsets */
     for(j=0;j<idx->off_cnt;j++) {
@@ -229,6 +250,7 @@ IndexPtr getindex(char *searchstr, int dbase)
        one, or NULL if no more alternatives for this word. */
 
     if (searchstr != NULL) {
+	WNTRACE_BEGIN(span);
 
 	offset = 0;
 	strtolower(searchstr);
@@ -241,8 +263,8 @@ IndexPtr getindex(char *searchstr, int dbase)
 	strsubst(strings[2], '-', '_');
 
 	/* remove all spaces and hyphens from last search string, then
-	   all periods */
-	for (i = j = k = 0; (c = searchstr[i]) != '\0'; i++) {
+	   all periods (from the copy, which fits) */
+	for (i = j = k = 0; (c = strings[0][i]) != '\0'; i++) {
 	    if (c != '_' && c != '-')
 		strings[3][j++] = c;
 	    if (c != '.')
@@ -260,6 +282,7 @@ IndexPtr getindex(char *searchstr, int dbase)
 	for (i = 1; i < MAX_FORMS; i++)
 	    if ((strings[i][0]) != '\0' && (strcmp(strings[0], strings[i])))
 		offsets[i] = index_lookup(strings[i], dbase);
+	WNTRACE_END(span, "getindex");
     }
 
 
@@ -278,6 +301,7 @@ IndexPtr getindex(char *searchstr, int dbase)
 SynsetPtr read_synset(int dbase, long boffset, char *word)
 {
     FILE *fp;
+    SynsetPtr synptr;
 
     if((fp = datafps[dbase]) == NULL) {
 	sprintf(msgbuf, "WordNet library error: %s datafile not open\n",
@@ -286,9 +310,23 @@ SynsetPtr read_synset(int dbase, long boffset, char *word)
 	return(NULL);
     }
     
-    fseek(fp, boffset, 0);	/* position file to byte offset requested */
-
-    return(parse_synset(fp, dbase, word)); /* parse synset and return */
+    {
+	WNTRACE_BEGIN(span);
+	switch (wn_map_line(fp, boffset, synline, LINEBUF)) {
+	case 1:			/* got line from memory */
+	    synptr = do_parse_synset(boffset, dbase, word);
+	    break;
+	case 0:
+	    synptr = NULL;
+	    break;
+	default:
+	    fseek(fp, boffset, 0); /* position file to byte offset requested */
+	    synptr = parse_synset(fp, dbase, word); /* parse synset */
+	    break;
+	}
+	WNTRACE_END(span, "read_synset");
+    }
+    return(synptr);
 }
 
 /* Read synset at current byte offset in file and return parsed entry
@@ -296,7 +334,22 @@ SynsetPtr read_synset(int dbase, long boffset, char *word)
 
 SynsetPtr parse_synset(FILE *fp, int dbase, char *word)
 {
-    static char line[LINEBUF];
+    long loc;			/* sanity check on file location */
+
+    loc = ftell(fp);
+
+    if (fgets(synline, LINEBUF, fp) == NULL)
+	return(NULL);
+    WNSTAT(bytesread, strlen(synline));
+
+    return(do_parse_synset(loc, dbase, word));
+}
+
+/* Parse synset in synline, which was read from file location loc */
+
+static SynsetPtr do_parse_synset(long loc, int dbase, char *word)
+{
+    char *line = synline;
     char tbuf[SMLINEBUF];
     char *ptrtok;
     char *tmpptr;
@@ -304,15 +357,11 @@ SynsetPtr parse_synset(FILE *fp, int dbase, char *word)
     char wdnum[3];
     int i;
     SynsetPtr synptr;
-    long loc;			/* sanity check on file location */
-
-    loc = ftell(fp);
-
-    if (fgets(line, LINEBUF, fp) == NULL)
-	return(NULL);
     
     synptr = (SynsetPtr)malloc(sizeof(Synset));
     assert(synptr);
+    WNSTAT(synsetsparsed, 1);
+    WNSTAT(allocs, 1);
     
     synptr->hereiam = 0;
     synptr->sstype = DONT_KNOW;
@@ -360,6 +409,7 @@ SynsetPtr parse_synset(FILE *fp, int dbase, char *word)
     ptrtok = strtok(NULL, " \n");
     synptr->pos = malloc(strlen(ptrtok) + 1);
     assert(synptr->pos);
+    WNSTAT(allocs, 1);
     snprintf(synptr->pos, strlen(ptrtok) + 1, "%s", ptrtok);
     if (getsstype(synptr->pos) == SATELLITE)
 	synptr->sstype = INDIRECT_ANT;
@@ -374,11 +424,13 @@ SynsetPtr parse_synset(FILE *fp, int dbase, char *word)
     assert(synptr->wnsns);
     synptr->lexid = (int *)malloc(synptr->wcount * sizeof(int));
     assert(synptr->lexid);
+    WNSTAT(allocs, 3);
     
     for (i = 0; i < synptr->wcount; i++) {
 	ptrtok = strtok(NULL, " \n");
 	synptr->words[i] = malloc(strlen(ptrtok) + 1);
 	assert(synptr->words[i]);
+	WNSTAT(allocs, 1);
 	snprintf(synptr->words[i], strlen(ptrtok) + 1, "%s", ptrtok);
 	
 	/* is this the word we're looking for? */
@@ -411,6 +463,7 @@ SynsetPtr parse_synset(FILE *fp, int dbase, char *word)
 	assert(synptr->pto);
 	synptr->pfrm = (int *)malloc(synptr->ptrcount * sizeof(int));
 	assert(synptr->pfrm);
+	WNSTAT(allocs, 5);
     
 	for(i = 0; i < synptr->ptrcount; i++) {
 	    /* get the pointer type */
@@ -464,6 +517,7 @@ SynsetPtr parse_synset(FILE *fp, int dbase, char *word)
 	assert(synptr->frmid);
 	synptr->frmto = (int *)malloc(synptr->fcount * sizeof(int));  
 	assert(synptr->frmto);
+	WNSTAT(allocs, 2);
 	
 	for(i=0;i<synptr->fcount;i++) {
 	    /* skip the frame pointer (+) */
@@ -492,6 +546,7 @@ SynsetPtr parse_synset(FILE *fp, int dbase, char *word)
 	assert((1 + strlen(tbuf)) < sizeof(tbuf));
 	synptr->defn = malloc(strlen(tbuf) + 4);
 	assert(synptr->defn);
+	WNSTAT(allocs, 1);
 	snprintf(synptr->defn, strlen(tbuf) + 4, "(%s)", tbuf);
     }
 
@@ -559,6 +614,67 @@ void free_synset(SynsetPtr synptr)
     free(synptr);
 }
 
+/* Copy a synset, without the lists linked to it */
+
+SynsetPtr copy_synset(SynsetPtr synptr)
+{
+    SynsetPtr cpy;
+    int i;
+
+    cpy = (SynsetPtr)malloc(sizeof(Synset));
+    assert(cpy);
+    WNSTAT(allocs, 1);
+    *cpy = *synptr;
+    cpy->nextss = cpy->nextform = cpy->ptrlist = NULL;
+
+    cpy->pos = strdup(synptr->pos);
+    cpy->words = (char **)malloc(synptr->wcount * sizeof(char *));
+    cpy->wnsns = (int *)malloc(synptr->wcount * sizeof(int));
+    cpy->lexid = (int *)malloc(synptr->wcount * sizeof(int));
+    assert(cpy->pos && cpy->words && cpy->wnsns && cpy->lexid);
+    for (i = 0; i < synptr->wcount; i++) {
+	cpy->words[i] = strdup(synptr->words[i]);
+	assert(cpy->words[i]);
+    }
+    memcpy(cpy->wnsns, synptr->wnsns, synptr->wcount * sizeof(int));
+    memcpy(cpy->lexid, synptr->lexid, synptr->wcount * sizeof(int));
+    WNSTAT(allocs, 4 + synptr->wcount);
+
+    if (synptr->ptrcount) {
+	cpy->ptrtyp = (int *)malloc(synptr->ptrcount * sizeof(int));
+	cpy->ptroff = (long *)malloc(synptr->ptrcount * sizeof(long));
+	cpy->ppos = (int *)malloc(synptr->ptrcount * sizeof(int));
+	cpy->pto = (int *)malloc(synptr->ptrcount * sizeof(int));
+	cpy->pfrm = (int *)malloc(synptr->ptrcount * sizeof(int));
+	assert(cpy->ptrtyp && cpy->ptroff && cpy->ppos && cpy->pto && cpy->pfrm);
+	memcpy(cpy->ptrtyp, synptr->ptrtyp, synptr->ptrcount * sizeof(int));
+	memcpy(cpy->ptroff, synptr->ptroff, synptr->ptrcount * sizeof(long));
+	memcpy(cpy->ppos, synptr->ppos, synptr->ptrcount * sizeof(int));
+	memcpy(cpy->pto, synptr->pto, synptr->ptrcount * sizeof(int));
+	memcpy(cpy->pfrm, synptr->pfrm, synptr->ptrcount * sizeof(int));
+	WNSTAT(allocs, 5);
+    }
+    if (synptr->fcount) {
+	cpy->frmid = (int *)malloc(synptr->fcount * sizeof(int));
+	cpy->frmto = (int *)malloc(synptr->fcount * sizeof(int));
+	assert(cpy->frmid && cpy->frmto);
+	memcpy(cpy->frmid, synptr->frmid, synptr->fcount * sizeof(int));
+	memcpy(cpy->frmto, synptr->frmto, synptr->fcount * sizeof(int));
+	WNSTAT(allocs, 2);
+    }
+    if (synptr->defn) {
+	cpy->defn = strdup(synptr->defn);
+	assert(cpy->defn);
+	WNSTAT(allocs, 1);
+    }
+    if (synptr->headword) {
+	cpy->headword = strdup(synptr->headword);
+	assert(cpy->headword);
+	WNSTAT(allocs, 1);
+    }
+    return(cpy);
+}
+
 /* Free an index structure */
 
 void free_index(IndexPtr idx)
@@ -571,180 +687,638 @@ void free_index(IndexPtr idx)
     free(idx);
 }
 
-/* Recursive search algorithm to trace a pointer tree */
+/* Pointer traces are run from an explicit stack of frames, one for each
+   synset on the path from the starting synset, instead of by recursion.
+   Each trace keeps the synsets on its current path in a bit set indexed
+   by synset offset.  Meeting one of them again means the pointers form a
+   cycle, so the trace reports it and goes no deeper, rather than running
+   on until MAXDEPTH.  The output is otherwise the same as that of the
+   recursive functions, which are kept for legacyflag. */
+
+struct traceframe {
+    SynsetPtr synptr;		/* synset whose pointers are being traced */
+    int ptrtyp, dbase, depth;
+    int next;			/* next pointer of synptr to look at */
+    SynsetPtr *tail;		/* traceptrs_ds(): where next result goes */
+    long start;			/* searchlen when frame was pushed */
+    long cycles;		/* ncycles when frame was pushed */
+};
+
+static struct traceframe *frames;
+static int nframes, maxframes;
+
+#define PATHSHIFT	4	/* synset lines are longer than 16 bytes */
+
+struct tracepath {
+    unsigned char *bits[NUMPARTS + 1];
+    long size[NUMPARTS + 1];	/* bytes in bits[] */
+};
+
+static struct tracepath ptrpath, coordpath, inheritpath, dspath;
+static long ncycles;		/* cycles found by traces */
+
+/* Hyponym trees reach some synsets through more than one hypernym.
+   The first time a synset's hyponyms are printed, the part of
+   searchbuffer holding them is remembered.  Later occurrences copy it
+   from there, re-indented, instead of reading the subtree again.
+   Subtrees in which a cycle was found depend on the path to them, so
+   they are not remembered. */
+
+struct subtree {
+    long offset;		/* synset offset */
+    int pos;
+    int depth;			/* depth its hyponyms were printed at */
+    long start, end;		/* where they are in searchbuffer */
+    unsigned long gen;		/* entry is valid if gen == subtreegen */
+};
+
+static struct subtree *subtrees;
+static long nsubtrees, maxsubtrees;
+static unsigned long subtreegen;
+
+static struct subtree *subtree_slot(struct subtree *table, long size,
+				    int pos, long offset)
+{
+    long i = ((unsigned long)offset * 31 + pos) & (size - 1);
+
+    while (table[i].gen == subtreegen &&
+	   (table[i].offset != offset || table[i].pos != pos))
+	i = (i + 1) & (size - 1);
+    return(&table[i]);
+}
+
+static struct subtree *subtree_find(SynsetPtr synptr)
+{
+    struct subtree *st;
+
+    if (nsubtrees == 0)
+	return(NULL);
+    st = subtree_slot(subtrees, maxsubtrees, getpos(synptr->pos),
+		      synptr->hereiam);
+    if (st->gen != subtreegen) {
+	WNSTAT(cachemisses, 1);
+	return(NULL);
+    }
+    WNSTAT(cachehits, 1);
+    return(st);
+}
+
+static void subtree_add(SynsetPtr synptr, int depth, long start, long end)
+{
+    struct subtree *table = subtrees, *st;
+    long i, size = maxsubtrees;
+
+    if (2 * (nsubtrees + 1) > maxsubtrees) {
+	maxsubtrees = maxsubtrees ? maxsubtrees * 2 : 1024;
+	subtrees = calloc(maxsubtrees, sizeof(struct subtree));
+	assert(subtrees);
+	WNSTAT(allocs, 1);
+	for (i = 0; i < size; i++)
+	    if (table[i].gen == subtreegen)
+		*subtree_slot(subtrees, maxsubtrees, table[i].pos,
+			      table[i].offset) = table[i];
+	free(table);
+    }
+    st = subtree_slot(subtrees, maxsubtrees, getpos(synptr->pos),
+		      synptr->hereiam);
+    st->offset = synptr->hereiam;
+    st->pos = getpos(synptr->pos);
+    st->depth = depth;
+    st->start = start;
+    st->end = end;
+    st->gen = subtreegen;
+    nsubtrees++;
+}
+
+/* Print subtree st again at depth.  Returns 0, printing nothing, if
+   it might not fit in searchbuffer, so that the caller can trace the
+   subtree itself and overflow at exactly the same point. */
+
+static int subtree_print(struct subtree *st, int depth)
+{
+    long p, eol, len = st->end - st->start;
+    int indent = 4 * (depth - st->depth);
+
+    /* Every line is indented by at least 4 * st->depth + 4 */
+    if (indent > 0)
+	len += len / (4 * st->depth + 4) * indent;
+    if (searchlen + len >= SEARCHBUF)
+	return(0);
+
+    for (p = st->start; p < st->end; p = eol) {
+	eol = (char *)memchr(searchbuffer + p, '\n', st->end - p) -
+	    searchbuffer + 1;
+	if (indent > 0)
+	    printspaces(0, indent / 4);
+	printbytes(searchbuffer + p - (indent < 0 ? indent : 0),
+		   eol - p + (indent < 0 ? indent : 0));
+    }
+    return(1);
+}
+
+/* Add synptr to path.  Returns 0 if it was already there. */
+
+static int path_enter(struct tracepath *path, SynsetPtr synptr)
+{
+    int pos = getpos(synptr->pos);
+    long slot = synptr->hereiam >> PATHSHIFT, size;
+    unsigned char mask = 1 << (slot & 7);
+
+    if (slot / 8 >= path->size[pos]) {
+	size = slot / 8 + 1 + path->size[pos];
+	path->bits[pos] = realloc(path->bits[pos], size);
+	assert(path->bits[pos]);
+	WNSTAT(allocs, 1);
+	memset(path->bits[pos] + path->size[pos], 0, size - path->size[pos]);
+	path->size[pos] = size;
+    }
+    if (path->bits[pos][slot / 8] & mask)
+	return(0);
+    path->bits[pos][slot / 8] |= mask;
+    return(1);
+}
+
+static void path_leave(struct tracepath *path, SynsetPtr synptr)
+{
+    long slot = synptr->hereiam >> PATHSHIFT;
+
+    path->bits[getpos(synptr->pos)][slot / 8] &= ~(1 << (slot & 7));
+}
+
+static void push_frame(SynsetPtr synptr, int ptrtyp, int dbase, int depth,
+		       SynsetPtr *tail)
+{
+    if (nframes == maxframes) {
+	maxframes = maxframes ? maxframes * 2 : 64;
+	frames = realloc(frames, maxframes * sizeof(struct traceframe));
+	assert(frames);
+	WNSTAT(allocs, 1);
+    }
+    frames[nframes].synptr = synptr;
+    frames[nframes].ptrtyp = ptrtyp;
+    frames[nframes].dbase = dbase;
+    frames[nframes].depth = depth;
+    frames[nframes].next = 0;
+    frames[nframes].tail = tail;
+    frames[nframes].start = searchlen;
+    frames[nframes].cycles = ncycles;
+    nframes++;
+}
+
+/* Pop the top frame of a trace whose first frame is base.  Synsets read
+   by the trace are freed if owned is set; the first is the caller's. */
+
+static void pop_frame(struct tracepath *path, int base, int owned)
+{
+    struct traceframe *f = &frames[--nframes];
+
+    if (f->depth)
+	path_leave(path, f->synptr);
+    if (owned && nframes > base)
+	free_synset(f->synptr);
+}
+
+/* Find next pointer of synptr, from i on, followed by traceptrs() */
+
+static int nextptr(SynsetPtr synptr, int ptrtyp, int i)
+{
+    for (; i < synptr->ptrcount; i++)
+	if ((ptrtyp == HYPERPTR && (synptr->ptrtyp[i] == HYPERPTR ||
+				    synptr->ptrtyp[i] == INSTANCE)) ||
+	    (ptrtyp == HYPOPTR && (synptr->ptrtyp[i] == HYPOPTR ||
+				   synptr->ptrtyp[i] == INSTANCES)) ||
+	    ((synptr->ptrtyp[i] == ptrtyp) &&
+	     ((synptr->pfrm[i] == 0) ||
+	      (synptr->pfrm[i] == synptr->whichword))))
+	    break;
+    return(i);
+}
+
+/* Find next hypernym (or instance if instances is set) of synptr, from
+   i on, followed by tracecoords() and traceinherit() */
+
+static int nexthyper(SynsetPtr synptr, int instances, int i)
+{
+    for (; i < synptr->ptrcount; i++)
+	if ((synptr->ptrtyp[i] == HYPERPTR ||
+	     (instances && synptr->ptrtyp[i] == INSTANCE)) &&
+	    ((synptr->pfrm[i] == 0) ||
+	     (synptr->pfrm[i] == synptr->whichword)))
+	    break;
+    return(i);
+}
+
+/* Print pointer i of synptr, indented for depth, and return the synset
+   it points to. */
+
+static SynsetPtr printptr(SynsetPtr synptr, int i, int ptrtyp, int dbase,
+			  int depth)
+{
+    SynsetPtr cursyn;
+    char prefix[40], tbuf[20];
+    int realptr;
+
+    realptr = synptr->ptrtyp[i]; /* deal with INSTANCE */
+
+    if(!prflag) {	/* print sense number and synset */
+	printsns(synptr, sense + 1);
+	prflag = 1;
+    }
+    printspaces(TRACEP, depth);
+
+    switch(realptr) {
+    case PERTPTR:
+	if (dbase == ADV) 
+	    sprintf(prefix, "Derived from %s ",
+		    partnames[synptr->ppos[i]]);
+	else
+	    sprintf(prefix, "Pertains to %s ",
+		    partnames[synptr->ppos[i]]);
+	break;
+    case ANTPTR:
+	if (dbase != ADJ)
+	    sprintf(prefix, "Antonym of ");
+	break;
+    case PPLPTR:
+	sprintf(prefix, "Participle of verb ");
+	break;
+    case INSTANCE:
+	sprintf(prefix, "INSTANCE OF=> ");
+	break;
+    case INSTANCES:
+	sprintf(prefix, "HAS INSTANCE=> ");
+	break;
+    case HASMEMBERPTR:
+	sprintf(prefix, "   HAS MEMBER: ");
+	break;
+    case HASSTUFFPTR:
+	sprintf(prefix, "   HAS SUBSTANCE: ");
+	break;
+    case HASPARTPTR:
+	sprintf(prefix, "   HAS PART: ");
+	break;
+    case ISMEMBERPTR:
+	sprintf(prefix, "   MEMBER OF: ");
+	break;
+    case ISSTUFFPTR:
+	sprintf(prefix, "   SUBSTANCE OF: ");
+	break;
+    case ISPARTPTR:
+	sprintf(prefix, "   PART OF: ");
+	break;
+    default:
+	sprintf(prefix, "=> ");
+	break;
+    }
+
+    /* Read synset pointed to */
+    cursyn=read_synset(synptr->ppos[i], synptr->ptroff[i], "");
+
+    /* For Pertainyms and Participles pointing to a specific
+       sense, indicate the sense then retrieve the synset
+       pointed to and other info as determined by type.
+       Otherwise, just print the synset pointed to. */
+
+    if ((ptrtyp == PERTPTR || ptrtyp == PPLPTR) &&
+	synptr->pto[i] != 0) {
+	sprintf(tbuf, " (Sense %d)\n",
+		cursyn->wnsns[synptr->pto[i] - 1]);
+	printsynset(prefix, cursyn, tbuf, DEFOFF, synptr->pto[i],
+		    SKIP_ANTS, PRINT_MARKER);
+	if (ptrtyp == PPLPTR) { /* adjective pointing to verb */
+	    printsynset("      =>", cursyn, "\n",
+			DEFON, ALLWORDS, PRINT_ANTS, PRINT_MARKER);
+	    traceptrs(cursyn, HYPERPTR, getpos(cursyn->pos), 0);
+	} else if (dbase == ADV) { /* adverb pointing to adjective */
+	    printsynset("      =>", cursyn, "\n",DEFON, ALLWORDS, 
+			((getsstype(cursyn->pos) == SATELLITE)
+			 ? SKIP_ANTS : PRINT_ANTS), PRINT_MARKER);
+#ifdef FOOP
+	    traceptrs(cursyn, HYPERPTR, getpos(cursyn->pos), 0);
+#endif
+	} else {	/* adjective pointing to noun */
+	    printsynset("      =>", cursyn, "\n",
+			DEFON, ALLWORDS, PRINT_ANTS, PRINT_MARKER);
+	    traceptrs(cursyn, HYPERPTR, getpos(cursyn->pos), 0);
+	}
+    } else if (ptrtyp == ANTPTR && dbase != ADJ && synptr->pto[i] != 0) {
+	sprintf(tbuf, " (Sense %d)\n",
+		cursyn->wnsns[synptr->pto[i] - 1]);
+	printsynset(prefix, cursyn, tbuf, DEFOFF, synptr->pto[i],
+		    SKIP_ANTS, PRINT_MARKER);
+	printsynset("      =>", cursyn, "\n", DEFON, ALLWORDS,
+		    PRINT_ANTS, PRINT_MARKER);
+    } else 
+	printsynset(prefix, cursyn, "\n", DEFON, ALLWORDS,
+		    PRINT_ANTS, PRINT_MARKER);
+
+    /* For HOLONYMS and MERONYMS, keep track of last one
+       printed in buffer so results can be truncated later. */
+
+    if (ptrtyp >= ISMEMBERPTR && ptrtyp <= HASPARTPTR)
+	lastholomero = searchlen;
+
+    return(cursyn);
+}
+
+/* Trace a pointer tree, printing each synset */
 
 static void traceptrs(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
+{
+    int i, top, base, extraindent = 0, memo;
+    struct traceframe *f;
+    struct subtree *st;
+    SynsetPtr cursyn;
+
+    if (legacyflag) {
+	traceptrs_r(synptr, ptrtyp, dbase, depth);
+	return;
+    }
+
+    interface_doevents();
+    if (abortsearch)
+	return;
+    WNTRACE_BEGIN(span);
+
+    if (ptrtyp < 0) {
+	ptrtyp = -ptrtyp;
+	extraindent = 2;
+    }
+
+    if ((memo = (ptrtyp == HYPOPTR && depth)) != 0) {
+	subtreegen++;
+	nsubtrees = 0;
+    }
+    base = nframes;
+    push_frame(synptr, ptrtyp, dbase, depth, NULL);
+    if (depth)
+	path_enter(&ptrpath, synptr);
+
+    while (nframes > base) {
+	if (overflag && prflag)
+	    break;		/* nothing more will be output */
+	top = nframes - 1;
+	f = &frames[top];
+	if (f->next == 0 && top > base) {
+	    interface_doevents();
+	    if (abortsearch)
+		break;
+	}
+	if ((i = nextptr(f->synptr, f->ptrtyp, f->next)) == f->synptr->ptrcount) {
+	    if (memo && top > base && f->cycles == ncycles)
+		subtree_add(f->synptr, f->depth, f->start, searchlen);
+	    pop_frame(&ptrpath, base, 1);
+	    continue;
+	}
+	f->next = i + 1;
+
+	cursyn = printptr(f->synptr, i, f->ptrtyp, f->dbase,
+			  f->depth + (top == base ? extraindent : 0));
+
+	f = &frames[top];	/* printptr() may have grown frames */
+	if (f->depth == 0)
+	    free_synset(cursyn);
+	else if (!path_enter(&ptrpath, cursyn)) {
+	    cycle_error(cursyn);
+	    free_synset(cursyn);
+	} else if (memo && (st = subtree_find(cursyn)) != NULL &&
+		   subtree_print(st, f->depth + 1)) {
+	    path_leave(&ptrpath, cursyn);
+	    free_synset(cursyn);
+	} else
+	    push_frame(cursyn, f->ptrtyp, getpos(cursyn->pos), f->depth + 1,
+		       NULL);
+    }
+    while (nframes > base)	/* aborted or overflowed */
+	pop_frame(&ptrpath, base, 1);
+    WNTRACE_END(span, "traceptrs");
+}
+
+/* Recursive search algorithm to trace a pointer tree */
+
+static void traceptrs_r(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
 {
     int i;
     int extraindent = 0;
     SynsetPtr cursyn;
-    char prefix[40], tbuf[20];
-    int realptr;
 
     interface_doevents();
     if (abortsearch)
 	return;
+    WNTRACE_BEGIN(span);
 
     if (ptrtyp < 0) {
 	ptrtyp = -ptrtyp;
 	extraindent = 2;
     }
     
-    for (i = 0; i < synptr->ptrcount; i++) {
-	if ((ptrtyp == HYPERPTR && (synptr->ptrtyp[i] == HYPERPTR ||
-				    synptr->ptrtyp[i] == INSTANCE)) ||
-	    (ptrtyp == HYPOPTR && (synptr->ptrtyp[i] == HYPOPTR ||
-				   synptr->ptrtyp[i] == INSTANCES)) ||
-	    ((synptr->ptrtyp[i] == ptrtyp) &&
-	     ((synptr->pfrm[i] == 0) ||
-	      (synptr->pfrm[i] == synptr->whichword)))) {
+    for (i = 0; (i = nextptr(synptr, ptrtyp, i)) < synptr->ptrcount; i++) {
+	cursyn = printptr(synptr, i, ptrtyp, dbase, depth + extraindent);
 
-	    realptr = synptr->ptrtyp[i]; /* deal with INSTANCE */
+	if(depth) {
+	    depth = depthcheck(depth, cursyn);
+	    traceptrs_r(cursyn, ptrtyp, getpos(cursyn->pos), (depth+1));
 
-	    if(!prflag) {	/* print sense number and synset */
-		printsns(synptr, sense + 1);
-		prflag = 1;
-	    }
-	    printspaces(TRACEP, depth + extraindent);
+	    free_synset(cursyn);
+	} else
+	    free_synset(cursyn);
+    }
+    WNTRACE_END(span, "traceptrs");
+}
 
-	    switch(realptr) {
-	    case PERTPTR:
-		if (dbase == ADV) 
-		    sprintf(prefix, "Derived from %s ",
-			    partnames[synptr->ppos[i]]);
-		else
-		    sprintf(prefix, "Pertains to %s ",
-			    partnames[synptr->ppos[i]]);
-		break;
-	    case ANTPTR:
-		if (dbase != ADJ)
-		    sprintf(prefix, "Antonym of ");
-		break;
-	    case PPLPTR:
-		sprintf(prefix, "Participle of verb ");
-		break;
-	    case INSTANCE:
-		sprintf(prefix, "INSTANCE OF=> ");
-		break;
-	    case INSTANCES:
-		sprintf(prefix, "HAS INSTANCE=> ");
-		break;
-	    case HASMEMBERPTR:
-		sprintf(prefix, "   HAS MEMBER: ");
-		break;
-	    case HASSTUFFPTR:
-		sprintf(prefix, "   HAS SUBSTANCE: ");
-		break;
-	    case HASPARTPTR:
-		sprintf(prefix, "   HAS PART: ");
-		break;
-	    case ISMEMBERPTR:
-		sprintf(prefix, "   MEMBER OF: ");
-		break;
-	    case ISSTUFFPTR:
-		sprintf(prefix, "   SUBSTANCE OF: ");
-		break;
-	    case ISPARTPTR:
-		sprintf(prefix, "   PART OF: ");
-		break;
-	    default:
-		sprintf(prefix, "=> ");
-		break;
-	    }
+/* Coordinate searches print every hyponym of each hypernym of the
+   search synset, and broad hypernyms are reached from many words.  The
+   most recent sibling lists are kept in memory: as the text printed
+   for tracecoords(), which depends on the output flags, and as parsed
+   synsets, which traceptrs_ds() hands out copies of. */
+
+#define SIBCACHE	256	/* hypernyms whose hyponyms are kept */
+
+static struct sibtext {
+    int pos;
+    long offset;		/* offset of hypernym; 0 if slot empty */
+    int flags;			/* output flags text was printed with */
+    char *text;
+    long len;
+} sibtexts[SIBCACHE];
+
+static struct sibsyns {
+    int pos;
+    long offset;
+    SynsetPtr syns;		/* hyponyms, linked by nextss */
+} sibsyns[SIBCACHE];
+
+#define SIBSLOT(pos, offset)	(((unsigned long)(offset) / 16 + (pos)) % SIBCACHE)
+#define SIBFLAGS	(offsetflag | fileinfoflag << 1 | dflag << 2 | \
+			 wnsnsflag << 3)
+
+void wn_flush_caches(void)
+{
+    int i;
 
-	    /* Read synset pointed to */
-	    cursyn=read_synset(synptr->ppos[i], synptr->ptroff[i], "");
+    for (i = 0; i < SIBCACHE; i++) {
+	free(sibtexts[i].text);
+	sibtexts[i].text = NULL;
+	sibtexts[i].offset = 0;
+	if (sibsyns[i].syns)
+	    free_syns(sibsyns[i].syns);
+	sibsyns[i].syns = NULL;
+	sibsyns[i].offset = 0;
+    }
+    wn_graph_free();
+    wn_derivations_free();
+    wn_ic_free();
+}
 
-	    /* For Pertainyms and Participles pointing to a specific
-	       sense, indicate the sense then retrieve the synset
-	       pointed to and other info as determined by type.
-	       Otherwise, just print the synset pointed to. */
+/* Print the hyponyms of synptr, as traceptrs(synptr, HYPOPTR, pos, 0)
+   does, from the cache if possible. */
 
-	    if ((ptrtyp == PERTPTR || ptrtyp == PPLPTR) &&
-		synptr->pto[i] != 0) {
-		sprintf(tbuf, " (Sense %d)\n",
-			cursyn->wnsns[synptr->pto[i] - 1]);
-		printsynset(prefix, cursyn, tbuf, DEFOFF, synptr->pto[i],
-			    SKIP_ANTS, PRINT_MARKER);
-		if (ptrtyp == PPLPTR) { /* adjective pointing to verb */
-		    printsynset("      =>", cursyn, "\n",
-				DEFON, ALLWORDS, PRINT_ANTS, PRINT_MARKER);
-		    traceptrs(cursyn, HYPERPTR, getpos(cursyn->pos), 0);
-		} else if (dbase == ADV) { /* adverb pointing to adjective */
-		    printsynset("      =>", cursyn, "\n",DEFON, ALLWORDS, 
-				((getsstype(cursyn->pos) == SATELLITE)
-				 ? SKIP_ANTS : PRINT_ANTS), PRINT_MARKER);
-#ifdef FOOP
- 		    traceptrs(cursyn, HYPERPTR, getpos(cursyn->pos), 0);
-#endif
-		} else {	/* adjective pointing to noun */
-		    printsynset("      =>", cursyn, "\n",
-				DEFON, ALLWORDS, PRINT_ANTS, PRINT_MARKER);
-		    traceptrs(cursyn, HYPERPTR, getpos(cursyn->pos), 0);
-		}
-	    } else if (ptrtyp == ANTPTR && dbase != ADJ && synptr->pto[i] != 0) {
-		sprintf(tbuf, " (Sense %d)\n",
-			cursyn->wnsns[synptr->pto[i] - 1]);
-		printsynset(prefix, cursyn, tbuf, DEFOFF, synptr->pto[i],
-			    SKIP_ANTS, PRINT_MARKER);
-		printsynset("      =>", cursyn, "\n", DEFON, ALLWORDS,
-			    PRINT_ANTS, PRINT_MARKER);
-	    } else 
-		printsynset(prefix, cursyn, "\n", DEFON, ALLWORDS,
-			    PRINT_ANTS, PRINT_MARKER);
+static void printsiblings(SynsetPtr synptr)
+{
+    struct sibtext *st;
+    int pos = getpos(synptr->pos);
+    long start = searchlen;
+
+    st = &sibtexts[SIBSLOT(pos, synptr->hereiam)];
+    if (st->offset == synptr->hereiam && st->pos == pos &&
+	st->flags == SIBFLAGS && searchlen + st->len < SEARCHBUF) {
+	WNSTAT(cachehits, 1);
+	printbytes(st->text, st->len);
+	return;
+    }
+    WNSTAT(cachemisses, 1);
 
-	    /* For HOLONYMS and MERONYMS, keep track of last one
-	       printed in buffer so results can be truncated later. */
+    /* Don't keep a list cut short by overflow or an abort */
+    traceptrs(synptr, HYPOPTR, pos, 0);
+    if (overflag || abortsearch)
+	return;
+    free(st->text);
+    if ((st->text = malloc(searchlen - start + 1)) == NULL) {
+	st->offset = 0;
+	return;
+    }
+    WNSTAT(allocs, 1);
+    memcpy(st->text, searchbuffer + start, searchlen - start);
+    st->len = searchlen - start;
+    st->offset = synptr->hereiam;
+    st->pos = pos;
+    st->flags = SIBFLAGS;
+}
 
-	    if (ptrtyp >= ISMEMBERPTR && ptrtyp <= HASPARTPTR)
-		lastholomero = strlen(searchbuffer);
+/* Copy list of synsets linked by nextss, setting their searchtype */
 
-	    if(depth) {
-		depth = depthcheck(depth, cursyn);
-		traceptrs(cursyn, ptrtyp, getpos(cursyn->pos), (depth+1));
+static SynsetPtr copy_syns(SynsetPtr syns, int searchtype)
+{
+    SynsetPtr synlist = NULL, *tail = &synlist;
 
-		free_synset(cursyn);
-	    } else
-		free_synset(cursyn);
-	}
+    for (; syns; syns = syns->nextss) {
+	*tail = copy_synset(syns);
+	(*tail)->searchtype = searchtype;
+	tail = &(*tail)->nextss;
     }
+    return(synlist);
+}
+
+/* Print a coordinate synset: the hypernym pointed to by pointer i of
+   synptr and its pointers of type ptrtyp. */
+
+static SynsetPtr printcoord(SynsetPtr synptr, int i, int ptrtyp, int depth)
+{
+    SynsetPtr cursyn;
+
+    if(!prflag) {
+	printsns(synptr, sense + 1);
+	prflag = 1;
+    }
+    printspaces(TRACEC, depth);
+
+    cursyn = read_synset(synptr->ppos[i], synptr->ptroff[i], "");
+
+    printsynset("-> ", cursyn, "\n", DEFON, ALLWORDS,
+		SKIP_ANTS, PRINT_MARKER);
+
+    if (ptrtyp == HYPOPTR && depth == 0 && !legacyflag)
+	printsiblings(cursyn);
+    else
+	traceptrs(cursyn, ptrtyp, getpos(cursyn->pos), depth);
+    return(cursyn);
 }
 
 static void tracecoords(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
 {
-    int i;
+    int i, top, base;
+    struct traceframe *f;
     SynsetPtr cursyn;
 
+    if (legacyflag) {
+	tracecoords_r(synptr, ptrtyp, dbase, depth);
+	return;
+    }
+
     interface_doevents();
     if (abortsearch)
 	return;
+    WNTRACE_BEGIN(span);
 
-    for(i = 0; i < synptr->ptrcount; i++) {
-	if((synptr->ptrtyp[i] == HYPERPTR || synptr->ptrtyp[i] == INSTANCE) &&
-	   ((synptr->pfrm[i] == 0) ||
-	    (synptr->pfrm[i] == synptr->whichword))) {
-	    
-	    if(!prflag) {
-		printsns(synptr, sense + 1);
-		prflag = 1;
-	    }
-	    printspaces(TRACEC, depth);
+    base = nframes;
+    push_frame(synptr, ptrtyp, dbase, depth, NULL);
+    if (depth)
+	path_enter(&coordpath, synptr);
 
-	    cursyn = read_synset(synptr->ppos[i], synptr->ptroff[i], "");
+    while (nframes > base) {
+	if (overflag && prflag)
+	    break;
+	top = nframes - 1;
+	f = &frames[top];
+	if (f->next == 0 && top > base) {
+	    interface_doevents();
+	    if (abortsearch)
+		break;
+	}
+	if ((i = nexthyper(f->synptr, 1, f->next)) == f->synptr->ptrcount) {
+	    pop_frame(&coordpath, base, 1);
+	    continue;
+	}
+	f->next = i + 1;
 
-	    printsynset("-> ", cursyn, "\n", DEFON, ALLWORDS,
-			SKIP_ANTS, PRINT_MARKER);
+	cursyn = printcoord(f->synptr, i, f->ptrtyp, f->depth);
 
-	    traceptrs(cursyn, ptrtyp, getpos(cursyn->pos), depth);
+	f = &frames[top];
+	if (f->depth == 0)
+	    free_synset(cursyn);
+	else if (!path_enter(&coordpath, cursyn)) {
+	    cycle_error(cursyn);
+	    free_synset(cursyn);
+	} else
+	    push_frame(cursyn, f->ptrtyp, getpos(cursyn->pos), f->depth + 1,
+		       NULL);
+    }
+    while (nframes > base)
+	pop_frame(&coordpath, base, 1);
+    WNTRACE_END(span, "tracecoords");
+}
+
+static void tracecoords_r(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
+{
+    int i;
+    SynsetPtr cursyn;
+
+    interface_doevents();
+    if (abortsearch)
+	return;
+    WNTRACE_BEGIN(span);
+
+    for(i = 0; (i = nexthyper(synptr, 1, i)) < synptr->ptrcount; i++) {
+	cursyn = printcoord(synptr, i, ptrtyp, depth);
 	    
-	    if(depth) {
-		depth = depthcheck(depth, cursyn);
-		tracecoords(cursyn, ptrtyp, getpos(cursyn->pos), (depth+1));
-		free_synset(cursyn);
-	    } else
-		free_synset(cursyn);
-	}
+	if(depth) {
+	    depth = depthcheck(depth, cursyn);
+	    tracecoords_r(cursyn, ptrtyp, getpos(cursyn->pos), (depth+1));
+	    free_synset(cursyn);
+	} else
+	    free_synset(cursyn);
     }
+    WNTRACE_END(span, "tracecoords");
 }
 
 static void traceclassif(SynsetPtr synptr, int dbase, int search)
@@ -872,49 +1446,161 @@ static void tracenomins(SynsetPtr synptr, int dbase)
     }
 }
 
+/* Print the hypernym of synptr at pos and offset and its MEMBER,
+   STUFF and PART info. */
+
+static SynsetPtr printinherit(SynsetPtr synptr, int pos, long offset,
+			      int ptrbase, int depth)
+{
+    SynsetPtr cursyn;
+
+    if(!prflag) {
+	printsns(synptr, sense + 1);
+	prflag = 1;
+    }
+    printspaces(TRACEI, depth);
+    
+    cursyn = read_synset(pos, offset, "");
+
+    printsynset("=> ", cursyn, "\n", DEFON, ALLWORDS,
+		SKIP_ANTS, PRINT_MARKER);
+    
+    traceptrs(cursyn, ptrbase, NOUN, depth);
+    traceptrs(cursyn, ptrbase + 1, NOUN, depth);
+    traceptrs(cursyn, ptrbase + 2, NOUN, depth);
+    return(cursyn);
+}
+
+/* Print the lines traceinherit() keeps of its trace of synptr from
+   the lists the graph holds for its hypernyms, reading only the
+   hypernyms printed.  Returns 0, printing nothing, if the list of any
+   of them isn't known. */
+
+static int inheritlist(SynsetPtr synptr, int ptrbase, int depth)
+{
+    SynsetPtr cursyn;
+    long hyper;
+    int i, j, d;
+
+    for (i = 0; (i = nexthyper(synptr, 0, i)) < synptr->ptrcount; i++)
+	if (synptr->ppos[i] != NOUN ||
+	    wn_graph_inherited(synptr->ptroff[i], ptrbase, 0, &hyper, &d) < 0)
+	    return(0);
+
+    for (i = 0; (i = nexthyper(synptr, 0, i)) < synptr->ptrcount; i++) {
+	j = wn_graph_inherited(synptr->ptroff[i], ptrbase, 0, &hyper, &d);
+
+	/* The sense is printed before the first hypernym, and cut off
+	   along with its line */
+	if (!prflag) {
+	    printsns(synptr, sense + 1);
+	    prflag = 1;
+	    if (j == 0 || d != 0)
+		truncbuffer(lastholomero);
+	}
+	for (; j > 0; j = wn_graph_inherited(synptr->ptroff[i], ptrbase, j,
+					     &hyper, &d)) {
+	    interface_doevents();
+	    if (abortsearch || (overflag && prflag))
+		return(1);
+	    cursyn = printinherit(synptr, NOUN, hyper, ptrbase, depth + d);
+	    free_synset(cursyn);
+	}
+    }
+    truncbuffer(lastholomero);
+    return(1);
+}
+
 /* Trace through the hypernym tree and print all MEMBER, STUFF
    and PART info. */
 
 static void traceinherit(SynsetPtr synptr, int ptrbase, int dbase, int depth)
 {
-    int i;
+    int i, top, base;
+    struct traceframe *f;
     SynsetPtr cursyn;
 
+    if (legacyflag) {
+	traceinherit_r(synptr, ptrbase, dbase, depth);
+	return;
+    }
+
     interface_doevents();
     if (abortsearch)
 	return;
-    
-    for(i=0;i<synptr->ptrcount;i++) {
-	if((synptr->ptrtyp[i] == HYPERPTR) &&
-	   ((synptr->pfrm[i] == 0) ||
-	    (synptr->pfrm[i] == synptr->whichword))) {
-	    
-	    if(!prflag) {
-		printsns(synptr, sense + 1);
-		prflag = 1;
-	    }
-	    printspaces(TRACEI, depth);
-	    
-	    cursyn = read_synset(synptr->ppos[i], synptr->ptroff[i], "");
+    WNTRACE_BEGIN(span);
 
-	    printsynset("=> ", cursyn, "\n", DEFON, ALLWORDS,
-			SKIP_ANTS, PRINT_MARKER);
-	    
-	    traceptrs(cursyn, ptrbase, NOUN, depth);
-	    traceptrs(cursyn, ptrbase + 1, NOUN, depth);
-	    traceptrs(cursyn, ptrbase + 2, NOUN, depth);
-	    
-	    if(depth) {
-		depth = depthcheck(depth, cursyn);
-		traceinherit(cursyn, ptrbase, getpos(cursyn->pos), (depth+1));
-		free_synset(cursyn);
-	    } else
-		free_synset(cursyn);
+    if (depth && wn_graph_ready() && inheritlist(synptr, ptrbase, depth)) {
+	WNTRACE_END(span, "traceinherit");
+	return;
+    }
+
+    base = nframes;
+    push_frame(synptr, ptrbase, dbase, depth, NULL);
+    if (depth)
+	path_enter(&inheritpath, synptr);
+
+    while (nframes > base) {
+	if (overflag && prflag)
+	    break;
+	top = nframes - 1;
+	f = &frames[top];
+	if (f->next == 0 && top > base) {
+	    interface_doevents();
+	    if (abortsearch)
+		break;
+	}
+	if ((i = nexthyper(f->synptr, 0, f->next)) == f->synptr->ptrcount) {
+	    /* Truncate search buffer after last holo/meronym printed */
+	    truncbuffer(lastholomero);
+	    pop_frame(&inheritpath, base, 1);
+	    continue;
 	}
+	f->next = i + 1;
+
+	cursyn = printinherit(f->synptr, f->synptr->ppos[i],
+			      f->synptr->ptroff[i], f->ptrtyp, f->depth);
+
+	f = &frames[top];
+	if (f->depth == 0)
+	    free_synset(cursyn);
+	else if (!path_enter(&inheritpath, cursyn)) {
+	    cycle_error(cursyn);
+	    free_synset(cursyn);
+	} else
+	    push_frame(cursyn, f->ptrtyp, getpos(cursyn->pos), f->depth + 1,
+		       NULL);
+    }
+    while (nframes > base)
+	pop_frame(&inheritpath, base, 1);
+    WNTRACE_END(span, "traceinherit");
+}
+
+static void traceinherit_r(SynsetPtr synptr, int ptrbase, int dbase, int depth)
+{
+    int i;
+    SynsetPtr cursyn;
+
+    interface_doevents();
+    if (abortsearch)
+	return;
+    WNTRACE_BEGIN(span);
+    
+    for(i = 0; (i = nexthyper(synptr, 0, i)) < synptr->ptrcount; i++) {
+	cursyn = printinherit(synptr, synptr->ppos[i], synptr->ptroff[i],
+			      ptrbase, depth);
+	    
+	if(depth) {
+	    depth = depthcheck(depth, cursyn);
+	    traceinherit_r(cursyn, ptrbase, getpos(cursyn->pos), (depth+1));
+	    free_synset(cursyn);
+	} else
+	    free_synset(cursyn);
     }
 
     /* Truncate search buffer after last holo/meronym printed */
-    searchbuffer[lastholomero] = '\0';
+    truncbuffer(lastholomero);
+    WNTRACE_END(span, "traceinherit");
 }
 
 static void partsall(SynsetPtr synptr, int ptrtyp)
@@ -941,7 +1627,7 @@ static void partsall(SynsetPtr synptr, int ptrtyp)
 	
 /*    if (hasptr && ptrtyp == HMERONYM) { */
     if (ptrtyp == HMERONYM) {
-	lastholomero = strlen(searchbuffer);
+	lastholomero = searchlen;
 	traceinherit(synptr, ptrbase, NOUN, 1);
     }
 }
@@ -1181,6 +1867,7 @@ void wngrep (char *word_passed, int pos) {
    wordlen = strlen (word);
 
    while (fgets (line, 1024, inputfile) != NULL) {
+      WNSTAT(bytesread, strlen(line));
       for (linelen = 0; line[linelen] != ' '; linelen++) {}
       if (linelen < wordlen)
 	  continue;
@@ -1322,6 +2009,7 @@ static struct relgrp *mkrellist(void)
 
     rel = (struct relgrp *) malloc(sizeof(struct relgrp));
     assert(rel);
+    WNSTAT(allocs, 1);
     for (i = 0; i < MAXSENSE; i++)
 	rel->senses[i] = 0;
     rel->next = NULL;
@@ -1378,255 +2066,342 @@ static void printrelatives(IndexPtr idx, int dbase)
     }
 }
 
-/*
-  Search code interfaces to WordNet database
+/* One spelling of a word in one part of speech, its index entries and
+   the synsets of their senses, each read the first time it's needed */
+
+struct wordform {
+    char word[WORDBUF];
+    int nidx;
+    IndexPtr idx[MAX_FORMS];
+    SynsetPtr *syns[MAX_FORMS];
+};
 
-  findtheinfo() - print search results and return ptr to output buffer
-  findtheinfo_ds() - return search results in linked list data structrure
-*/
+/* Look up each index entry getindex() finds for searchstr */
 
-char *findtheinfo(char *searchstr, int dbase, int ptrtyp, int whichsense)
+static void resolve_form(struct wordform *wf, char *searchstr, int dbase)
+{
+    IndexPtr idx;
+
+    wf->nidx = 0;
+    while (wf->nidx < MAX_FORMS &&
+	   (idx = getindex(searchstr, dbase)) != NULL) {
+	searchstr = NULL;	/* clear out for next call to getindex() */
+	wf->syns[wf->nidx] = calloc(idx->off_cnt > 0 ? idx->off_cnt : 1,
+				    sizeof(SynsetPtr));
+	WNSTAT(allocs, 1);
+	wf->idx[wf->nidx++] = idx;
+    }
+}
+
+/* Return the synset of sense snum of index entry i.  If there was no
+   memory to keep it, the caller must free it. */
+
+static SynsetPtr form_synset(struct wordform *wf, int i, int snum, int dbase)
+{
+    IndexPtr idx = wf->idx[i];
+
+    if (wf->syns[i] == NULL)
+	return(read_synset(dbase, idx->offset[snum], idx->wd));
+    if (wf->syns[i][snum] == NULL)
+	wf->syns[i][snum] = read_synset(dbase, idx->offset[snum], idx->wd);
+    return(wf->syns[i][snum]);
+}
+
+static void free_form(struct wordform *wf)
+{
+    int i, j;
+
+    for (i = 0; i < wf->nidx; i++) {
+	if (wf->syns[i] != NULL) {
+	    for (j = 0; j < wf->idx[i]->off_cnt; j++)
+		if (wf->syns[i][j] != NULL)
+		    free_synset(wf->syns[i][j]);
+	    free(wf->syns[i]);
+	}
+	free_index(wf->idx[i]);
+    }
+    wf->nidx = 0;
+}
+
+/* Do search ptrtyp on each sense of the word form wf, appending the
+   output to searchbuffer as findtheinfo() does. */
+
+static void search_form(struct wordform *wf, int dbase, int ptrtyp,
+			int whichsense)
 {
     SynsetPtr cursyn;
-    IndexPtr idx = NULL;
+    IndexPtr idx;
     int depth = 0;
-    int i, offsetcnt;
+    int f, i, offsetcnt;
     char *bufstart;
     unsigned long offsets[MAXSENSE];
-    int skipit;
-
-    /* Initializations -
-       clear output buffer, search results structure, flags */
-
-    searchbuffer[0] = '\0';
-
-    wnresults.numforms = wnresults.printcnt = 0;
-    wnresults.searchbuf = searchbuffer;
-    wnresults.searchds = NULL;
+    int skipit = 0;
 
-    abortsearch = overflag = 0;
     for (i = 0; i < MAXSENSE; i++)
 	offsets[i] = 0;
 
-    switch (ptrtyp) {
-    case OVERVIEW:
-	WNOverview(searchstr, dbase);
-	break;
-    case FREQ:
-	while ((idx = getindex(searchstr, dbase)) != NULL) {
-	    searchstr = NULL;
-	    wnresults.SenseCount[wnresults.numforms] = idx->off_cnt;
-	    freq_word(idx);
-	    free_index(idx);
-	    wnresults.numforms++;
-	}
-	break;
-    case WNGREP:
-	wngrep(searchstr, dbase);
-	break;
-    case RELATIVES:
-    case VERBGROUP:
-	while ((idx = getindex(searchstr, dbase)) != NULL) {
-	    searchstr = NULL;
-	    wnresults.SenseCount[wnresults.numforms] = idx->off_cnt;
-	    relatives(idx, dbase);
-	    free_index(idx);
-	    wnresults.numforms++;
-	}
-	break;
-    default:
-
-	/* If negative search type, set flag for recursive search */
-	if (ptrtyp < 0) {
-	    ptrtyp = -ptrtyp;
-	    depth = 1;
-	}
-	bufstart = searchbuffer;
-	offsetcnt = 0;
+    /* If negative search type, set flag for recursive search */
+    if (ptrtyp < 0) {
+	ptrtyp = -ptrtyp;
+	depth = 1;
+    }
+    bufstart = searchbuffer;
+    offsetcnt = 0;
 
-	/* look at all spellings of word */
+    /* look at all spellings of word */
 
-	while ((idx = getindex(searchstr, dbase)) != NULL) {
+    for (f = 0; f < wf->nidx; f++) {
 
-	    searchstr = NULL;	/* clear out for next call to getindex() */
-	    wnresults.SenseCount[wnresults.numforms] = idx->off_cnt;
-	    wnresults.OutSenseCount[wnresults.numforms] = 0;
+	idx = wf->idx[f];
+	wnresults.SenseCount[wnresults.numforms] = idx->off_cnt;
+	wnresults.OutSenseCount[wnresults.numforms] = 0;
 
-	    /* Print extra sense msgs if looking at all senses */
-	    if (whichsense == ALLSENSES)
-		printbuffer(
+	/* Print extra sense msgs if looking at all senses */
+	if (whichsense == ALLSENSES)
+	    printbuffer(
 "                                                                         \n");
 
-	    /* Go through all of the searchword's senses in the
-	       database and perform the search requested. */
+	/* Go through all of the searchword's senses in the
+	   database and perform the search requested. */
 
-	    for (sense = 0; sense < idx->off_cnt; sense++) {
+	for (sense = 0; sense < idx->off_cnt; sense++) {
 
-		if (whichsense == ALLSENSES || whichsense == sense + 1) {
-		    prflag = 0;
+	    if (whichsense == ALLSENSES || whichsense == sense + 1) {
+		prflag = 0;
+
+		/* Determine if this synset has already been done
+		   with a different spelling. If so, skip it. */
+		for (i = 0, skipit = 0; i < offsetcnt && !skipit; i++) {
+		    if (offsets[i] == idx->offset[sense])
+			skipit = 1;
+		}
+		if (skipit != 1) {
+		    offsets[offsetcnt++] = idx->offset[sense];
+		    cursyn = form_synset(wf, f, sense, dbase);
+		    switch(ptrtyp) {
+		    case ANTPTR:
+			if(dbase == ADJ)
+			    traceadjant(cursyn);
+			else
+			    traceptrs(cursyn, ANTPTR, dbase, depth);
+			break;
+
+		    case COORDS:
+			tracecoords(cursyn, HYPOPTR, dbase, depth);
+			break;
+
+		    case FRAMES:
+			printframe(cursyn, 1);
+			break;
+
+		    case MERONYM:
+			traceptrs(cursyn, HASMEMBERPTR, dbase, depth);
+			traceptrs(cursyn, HASSTUFFPTR, dbase, depth);
+			traceptrs(cursyn, HASPARTPTR, dbase, depth);
+			break;
+
+		    case HOLONYM:
+			traceptrs(cursyn, ISMEMBERPTR, dbase, depth);
+			traceptrs(cursyn, ISSTUFFPTR, dbase, depth);
+			traceptrs(cursyn, ISPARTPTR, dbase, depth);
+			break;
+
+		    case HMERONYM:
+			partsall(cursyn, HMERONYM);
+			break;
+
+		    case HHOLONYM:
+			partsall(cursyn, HHOLONYM);
+			break;
+
+		    case SEEALSOPTR:
+			printseealso(cursyn);
+			break;
 
-		    /* Determine if this synset has already been done
-		       with a different spelling. If so, skip it. */
-		    for (i = 0, skipit = 0; i < offsetcnt && !skipit; i++) {
-			if (offsets[i] == idx->offset[sense])
-			    skipit = 1;
-		    }
-		    if (skipit != 1) {
-		    	offsets[offsetcnt++] = idx->offset[sense];
-		    	cursyn = read_synset(dbase, idx->offset[sense], idx->wd);
-		    	switch(ptrtyp) {
-		    	case ANTPTR:
-			    if(dbase == ADJ)
-			    	traceadjant(cursyn);
-			    else
-			    	traceptrs(cursyn, ANTPTR, dbase, depth);
-			    break;
-		   	 
-		    	case COORDS:
-			    tracecoords(cursyn, HYPOPTR, dbase, depth);
-			    break;
-		   	 
-		    	case FRAMES:
-			    printframe(cursyn, 1);
-			    break;
-			    
-		    	case MERONYM:
-			    traceptrs(cursyn, HASMEMBERPTR, dbase, depth);
-			    traceptrs(cursyn, HASSTUFFPTR, dbase, depth);
-			    traceptrs(cursyn, HASPARTPTR, dbase, depth);
-			    break;
-			    
-		    	case HOLONYM:
-			    traceptrs(cursyn, ISMEMBERPTR, dbase, depth);
-			    traceptrs(cursyn, ISSTUFFPTR, dbase, depth);
-			    traceptrs(cursyn, ISPARTPTR, dbase, depth);
-			    break;
-			   	 
-		    	case HMERONYM:
-			    partsall(cursyn, HMERONYM);
-			    break;
-			   	 
-		    	case HHOLONYM:
-			    partsall(cursyn, HHOLONYM);
-			    break;
-			   	 
-		    	case SEEALSOPTR:
-			    printseealso(cursyn);
-			    break;
-	
 #ifdef FOOP
-			case PPLPTR:
-			    traceptrs(cursyn, ptrtyp, dbase, depth);
-			    traceptrs(cursyn, PPLPTR, dbase, depth);
-			    break;
+		    case PPLPTR:
+			traceptrs(cursyn, ptrtyp, dbase, depth);
+			traceptrs(cursyn, PPLPTR, dbase, depth);
+			break;
 #endif
-		    
-		    	case SIMPTR:
-		    	case SYNS:
-		    	case HYPERPTR:
-			    printsns(cursyn, sense + 1);
-			    prflag = 1;
-		    
-			    traceptrs(cursyn, ptrtyp, dbase, depth);
-		    
-			    if (dbase == ADJ) {
+
+		    case SIMPTR:
+		    case SYNS:
+		    case HYPERPTR:
+			printsns(cursyn, sense + 1);
+			prflag = 1;
+
+			traceptrs(cursyn, ptrtyp, dbase, depth);
+
+			if (dbase == ADJ) {
 /*			    	traceptrs(cursyn, PERTPTR, dbase, depth); */
-			    	traceptrs(cursyn, PPLPTR, dbase, depth);
-			    } else if (dbase == ADV) {
+			    traceptrs(cursyn, PPLPTR, dbase, depth);
+			} else if (dbase == ADV) {
 /*			    	traceptrs(cursyn, PERTPTR, dbase, depth);*/
-			    }
+			}
 
-			    if (saflag)	/* print SEE ALSO pointers */
-			    	printseealso(cursyn);
-			    
-			    if (dbase == VERB && frflag)
-			    	printframe(cursyn, 0);
-			    break;
+			if (saflag)	/* print SEE ALSO pointers */
+			    printseealso(cursyn);
 
-			case PERTPTR:
-			    printsns(cursyn, sense + 1);
-			    prflag = 1;
-		    
-			    traceptrs(cursyn, PERTPTR, dbase, depth);
-			    break;
+			if (dbase == VERB && frflag)
+			    printframe(cursyn, 0);
+			break;
 
-			case DERIVATION:
-			    tracenomins(cursyn, dbase);
-			    break;
+		    case PERTPTR:
+			printsns(cursyn, sense + 1);
+			prflag = 1;
 
-			case CLASSIFICATION:
-			case CLASS:
-			    traceclassif(cursyn, dbase, ptrtyp);
-			    break;
+			traceptrs(cursyn, PERTPTR, dbase, depth);
+			break;
 
-		    	default:
-			    traceptrs(cursyn, ptrtyp, dbase, depth);
-			    break;
+		    case DERIVATION:
+			tracenomins(cursyn, dbase);
+			break;
 
-		    	} /* end switch */
+		    case CLASSIFICATION:
+		    case CLASS:
+			traceclassif(cursyn, dbase, ptrtyp);
+			break;
 
-		    	free_synset(cursyn);
+		    default:
+			traceptrs(cursyn, ptrtyp, dbase, depth);
+			break;
 
-		    } /* end if (skipit) */
+		    } /* end switch */
 
-		} /* end if (whichsense) */
+		    if (wf->syns[f] == NULL)
+		        free_synset(cursyn);
 
-		if (skipit != 1) {
-		    interface_doevents();
-		    if ((whichsense == sense + 1) || abortsearch || overflag)
-		    	break;	/* break out of loop - we're done */
-		}
+		} /* end if (skipit) */
+
+	    } /* end if (whichsense) */
 
-	    } /* end for (sense) */
+	    if (skipit != 1) {
+		interface_doevents();
+		if ((whichsense == sense + 1) || abortsearch || overflag)
+		    break;	/* break out of loop - we're done */
+	    }
 
-	    /* Done with an index entry - patch in number of senses output */
+	} /* end for (sense) */
 
-	    if (whichsense == ALLSENSES) {
-		i = wnresults.OutSenseCount[wnresults.numforms];
-		if (i == idx->off_cnt && i == 1)
-		    sprintf(tmpbuf, "\n1 sense of %s", idx->wd);
-		else if (i == idx->off_cnt)
-		    sprintf(tmpbuf, "\n%d senses of %s", i, idx->wd);
-		else if (i > 0)	/* printed some senses */
-		    sprintf(tmpbuf, "\n%d of %d senses of %s",
-			    i, idx->off_cnt, idx->wd);
+	/* Done with an index entry - patch in number of senses output */
 
-		/* Find starting offset in searchbuffer for this index
-		   entry and patch string in.  Then update bufstart
-		   to end of searchbuffer for start of next index entry. */
+	if (whichsense == ALLSENSES) {
+	    i = wnresults.OutSenseCount[wnresults.numforms];
+	    if (i == idx->off_cnt && i == 1)
+		sprintf(tmpbuf, "\n1 sense of %s", idx->wd);
+	    else if (i == idx->off_cnt)
+		sprintf(tmpbuf, "\n%d senses of %s", i, idx->wd);
+	    else if (i > 0)	/* printed some senses */
+		sprintf(tmpbuf, "\n%d of %d senses of %s",
+			i, idx->off_cnt, idx->wd);
 
-		if (i > 0) {
-		    if (wnresults.numforms > 0) {
-			bufstart[0] = '\n';
-			bufstart++;
-		    }
-		    strncpy(bufstart, tmpbuf, strlen(tmpbuf));
-		    bufstart = searchbuffer + strlen(searchbuffer);
+	    /* Find starting offset in searchbuffer for this index
+	       entry and patch string in.  Then update bufstart
+	       to end of searchbuffer for start of next index entry. */
+
+	    if (i > 0) {
+		if (wnresults.numforms > 0) {
+		    bufstart[0] = '\n';
+		    bufstart++;
 		}
+		strncpy(bufstart, tmpbuf, strlen(tmpbuf));
+		bufstart = searchbuffer + strlen(searchbuffer);
 	    }
+	}
 
-	    free_index(idx);
+	interface_doevents();
+	if (overflag || abortsearch)
+	    break;		/* break out of for (f) loop */
 
-	    interface_doevents();
-	    if (overflag || abortsearch)
-		break;		/* break out of while (idx) loop */
+	wnresults.numforms++;
 
-	    wnresults.numforms++;
+    } /* end for (f) */
+}
 
-	} /* end while (idx) */
+/* Initializations for a search -
+   clear output buffer, search results structure, flags */
 
-    } /* end switch */
+static void begin_search(void)
+{
+    truncbuffer(0);
 
+    wnresults.numforms = wnresults.printcnt = 0;
+    wnresults.searchbuf = searchbuffer;
+    wnresults.searchds = NULL;
+
+    abortsearch = overflag = 0;
+}
+
+/* Finish the output of a search */
+
+static void end_search(void)
+{
     interface_doevents();
     if (abortsearch)
 	printbuffer("\nSearch Interrupted...\n");
     else if (overflag)
-	sprintf(searchbuffer,
+	searchlen = sprintf(searchbuffer,
 		"Search too large.  Narrow search and try again...\n");
 
     /* replace underscores with spaces before returning */
 
-    return(strsubst(searchbuffer, '_', ' '));
+    strsubst(searchbuffer, '_', ' ');
+}
+
+/*
+  Search code interfaces to WordNet database
+
+  findtheinfo() - print search results and return ptr to output buffer
+  findtheinfo_ds() - return search results in linked list data structrure
+*/
+
+char *findtheinfo(char *searchstr, int dbase, int ptrtyp, int whichsense)
+{
+    IndexPtr idx = NULL;
+    struct wordform wf;
+    WNTRACE_BEGIN(span);
+
+    wn_stats_reset(WNSTATS_QUERY);
+    begin_search();
+
+    switch (ptrtyp) {
+    case OVERVIEW:
+	WNOverview(searchstr, dbase);
+	break;
+    case FREQ:
+	while ((idx = getindex(searchstr, dbase)) != NULL) {
+	    searchstr = NULL;
+	    wnresults.SenseCount[wnresults.numforms] = idx->off_cnt;
+	    freq_word(idx);
+	    free_index(idx);
+	    wnresults.numforms++;
+	}
+	break;
+    case WNGREP:
+	wngrep(searchstr, dbase);
+	break;
+    case RELATIVES:
+    case VERBGROUP:
+	while ((idx = getindex(searchstr, dbase)) != NULL) {
+	    searchstr = NULL;
+	    wnresults.SenseCount[wnresults.numforms] = idx->off_cnt;
+	    relatives(idx, dbase);
+	    free_index(idx);
+	    wnresults.numforms++;
+	}
+	break;
+    default:
+	resolve_form(&wf, searchstr, dbase);
+	search_form(&wf, dbase, ptrtyp, whichsense);
+	free_form(&wf);
+	break;
+
+    } /* end switch */
+
+    end_search();
+    WNTRACE_END(span, "findtheinfo");
+    return(searchbuffer);
 }
 
 SynsetPtr findtheinfo_ds(char *searchstr, int dbase, int ptrtyp, int whichsense)
@@ -1636,7 +2411,9 @@ SynsetPtr findtheinfo_ds(char *searchstr, int dbase, int ptrtyp, int whichsense)
     SynsetPtr synlist = NULL, lastsyn = NULL;
     int depth = 0;
     int newsense = 0;
+    WNTRACE_BEGIN(span);
 
+    wn_stats_reset(WNSTATS_QUERY);
     wnresults.numforms = 0;
     wnresults.printcnt = 0;
 
@@ -1692,20 +2469,17 @@ SynsetPtr findtheinfo_ds(char *searchstr, int dbase, int ptrtyp, int whichsense)
 	}
     }
     wnresults.searchds = synlist;
+    WNTRACE_END(span, "findtheinfo_ds");
     return(synlist);
 }
 
-/* Recursive search algorithm to trace a pointer tree and return results
-  in linked list of data structures. */
+/* If synset is a satellite, find the head word of its
+   head synset and the head word's sense number. */
 
-SynsetPtr traceptrs_ds(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
+static void getheadword(SynsetPtr synptr)
 {
     int i;
-    SynsetPtr cursyn, synlist = NULL, lastsyn = NULL;
-    int tstptrtyp, docoords;
-    
-    /* If synset is a satellite, find the head word of its
-       head synset and the head word's sense number. */
+    SynsetPtr cursyn;
 
     if (getsstype(synptr->pos) == SATELLITE) {
 	for (i = 0; i < synptr->ptrcount; i++)
@@ -1715,6 +2489,7 @@ SynsetPtr traceptrs_ds(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
 				      "");
 		synptr->headword = malloc(strlen(cursyn->words[0]) + 1);
 		assert(synptr->headword);
+		WNSTAT(allocs, 1);
 		snprintf(synptr->headword,
 			 strlen(cursyn->words[0]) + 1,
 			 "%s",
@@ -1724,6 +2499,91 @@ SynsetPtr traceptrs_ds(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
 		break;
 	    }
     }
+}
+
+/* Trace a pointer tree and return results in linked list of data
+   structures. */
+
+SynsetPtr traceptrs_ds(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
+{
+    int i, top, base, tstptrtyp, pos;
+    struct traceframe *f;
+    struct sibsyns *ss;
+    SynsetPtr cursyn, synlist = NULL;
+
+    if (legacyflag)
+	return(traceptrs_ds_r(synptr, ptrtyp, dbase, depth));
+
+    getheadword(synptr);
+
+    /* Hyponyms of a coordinate search's hypernym */
+    if (ptrtyp == HYPOPTR && depth == 0 && synptr->whichword == 0) {
+	pos = getpos(synptr->pos);
+	ss = &sibsyns[SIBSLOT(pos, synptr->hereiam)];
+	if (ss->syns && ss->offset == synptr->hereiam && ss->pos == pos) {
+	    WNSTAT(cachehits, 1);
+	    return(copy_syns(ss->syns, ptrtyp));
+	}
+	WNSTAT(cachemisses, 1);
+    } else
+	ss = NULL;
+    base = nframes;
+    push_frame(synptr, ptrtyp, dbase, depth, &synlist);
+    if (depth)
+	path_enter(&dspath, synptr);
+
+    while (nframes > base) {
+	top = nframes - 1;
+	f = &frames[top];
+	tstptrtyp = (f->ptrtyp == COORDS) ? HYPERPTR : f->ptrtyp;
+	for (i = f->next; i < f->synptr->ptrcount; i++)
+	    if ((f->synptr->ptrtyp[i] == tstptrtyp) &&
+		((f->synptr->pfrm[i] == 0) ||
+		 (f->synptr->pfrm[i] == f->synptr->whichword)))
+		break;
+	if (i == f->synptr->ptrcount) {
+	    pop_frame(&dspath, base, 0);
+	    continue;
+	}
+	f->next = i + 1;
+
+	cursyn = read_synset(f->synptr->ppos[i], f->synptr->ptroff[i], "");
+	cursyn->searchtype = f->ptrtyp;
+	*f->tail = cursyn;
+	f->tail = &cursyn->nextss;
+
+	if (f->depth) {
+	    if (!path_enter(&dspath, cursyn))
+		cycle_error(cursyn);
+	    else {
+		getheadword(cursyn);
+		push_frame(cursyn, f->ptrtyp, getpos(cursyn->pos),
+			   f->depth + 1, &cursyn->ptrlist);
+	    }
+	} else if (f->ptrtyp == COORDS)
+	    cursyn->ptrlist = traceptrs_ds(cursyn, HYPOPTR, NOUN, 0);
+    }
+
+    if (ss) {
+	if (ss->syns)
+	    free_syns(ss->syns);
+	ss->syns = copy_syns(synlist, ptrtyp);
+	ss->offset = synptr->hereiam;
+	ss->pos = pos;
+    }
+    return(synlist);
+}
+
+/* Recursive search algorithm to trace a pointer tree and return results
+  in linked list of data structures. */
+
+static SynsetPtr traceptrs_ds_r(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
+{
+    int i;
+    SynsetPtr cursyn, synlist = NULL, lastsyn = NULL;
+    int tstptrtyp, docoords;
+    
+    getheadword(synptr);
 
     if (ptrtyp == COORDS) {
 	tstptrtyp = HYPERPTR;
@@ -1749,17 +2609,17 @@ SynsetPtr traceptrs_ds(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
 
 	    if(depth) {
 		depth = depthcheck(depth, cursyn);
-		cursyn->ptrlist = traceptrs_ds(cursyn, ptrtyp,
-					       getpos(cursyn->pos),
-					       (depth+1));
+		cursyn->ptrlist = traceptrs_ds_r(cursyn, ptrtyp,
+						 getpos(cursyn->pos),
+						 (depth+1));
 	    } else if (docoords) {
-		cursyn->ptrlist = traceptrs_ds(cursyn, HYPOPTR, NOUN, 0);
+		cursyn->ptrlist = traceptrs_ds_r(cursyn, HYPOPTR, NOUN, 0);
 	    }
 	}
     }
     return(synlist);
 }
-
+
 static void WNOverview(char *searchstr, int pos)
 {
     SynsetPtr cursyn;
@@ -1769,7 +2629,7 @@ static void WNOverview(char *searchstr, int pos)
     int svdflag, skipit;
     unsigned long offsets[MAXSENSE];
 
-    bufstart = searchbuffer;
+    bufstart = searchbuffer + searchlen;
     for (i = 0; i < MAXSENSE; i++)
 	offsets[i] = 0;
     offsetcnt = 0;
@@ -1797,8 +2657,9 @@ static void WNOverview(char *searchstr, int pos)
 		cursyn = read_synset(pos, idx->offset[sense], idx->wd);
 		if (idx->tagged_cnt != -1 &&
 		    ((sense + 1) <= idx->tagged_cnt)) {
-		  sprintf(tmpbuf, "%d. (%d) ",
-			  sense + 1, GetTagcnt(idx, sense + 1));
+		  sprintf(tmpbuf, "%d. (%d) ", sense + 1,
+			  legacyflag ? GetTagcnt(idx, sense + 1) :
+			  GetSynsetTagcnt(idx, cursyn));
 		} else {
 		  sprintf(tmpbuf, "%d. ", sense + 1);
 		}
@@ -1836,18 +2697,148 @@ static void WNOverview(char *searchstr, int pos)
 	    strncpy(bufstart, tmpbuf, strlen(tmpbuf));
 	    bufstart = searchbuffer + strlen(searchbuffer);
 	} else
-	    bufstart[0] = '\0';
+	    truncbuffer(bufstart - searchbuffer);
 
 	wnresults.numforms++;
 	free_index(idx);
     }
 }
 
+/* Append the overview of one form of a word in pos to the output,
+   with a header line, or nothing if it has no senses.  Returns the
+   number of senses printed. */
+
+static int overview_form(char *word, int pos)
+{
+    long start = searchlen, body;
+
+    snprintf(tmpbuf, TMPBUFSIZE, "\nOverview of %s %s\n",
+	     partnames[pos], word);
+    printbuffer(tmpbuf);
+    body = searchlen;
+    wnresults.numforms = wnresults.printcnt = 0;
+    WNOverview(word, pos);
+    if (searchlen == body)
+	truncbuffer(start);
+    else
+	strsubst(searchbuffer + body, '_', ' ');
+    return(wnresults.printcnt);
+}
+
+/* Return the overview of searchstr and each of its base forms in every
+   part of speech, as "wn word -over" prints them, in one buffer.  The
+   word is converted to the form used in the database once, and no
+   synset is read twice for a sense. */
+
+char *wn_overview(char *searchstr)
+{
+    char word[WORDBUF], *morph_word;
+    int pos, printcnt = 0;
+    WNTRACE_BEGIN(span);
+
+    truncbuffer(0);
+    wn_stats_reset(WNSTATS_QUERY);
+    wnresults.numforms = wnresults.printcnt = 0;
+    wnresults.searchbuf = searchbuffer;
+    wnresults.searchds = NULL;
+    abortsearch = overflag = 0;
+
+    snprintf(word, sizeof(word), "%s", searchstr);
+    strtolower(strsubst(word, ' ', '_'));
+
+    for (pos = 1; pos <= NUMPARTS && !abortsearch; pos++) {
+	printcnt += overview_form(word, pos);
+	if ((morph_word = morphstr(word, pos)) != NULL)
+	    do {
+		printcnt += overview_form(morph_word, pos);
+	    } while ((morph_word = morphstr(NULL, pos)) != NULL);
+    }
+    wnresults.printcnt = printcnt;
+
+    interface_doevents();
+    if (abortsearch)
+	printbuffer("\nSearch Interrupted...\n");
+    else if (overflag)
+	searchlen = sprintf(searchbuffer,
+		"Search too large.  Narrow search and try again...\n");
+    WNTRACE_END(span, "wn_overview");
+    return(searchbuffer);
+}
+
+/* Do each of the nsearch searches in ptrtyps on searchstr and each of
+   its base forms in dbase, in the order "wn" prints them: every form
+   for the first search, then every form for the next.  func is called
+   after each with the index of the search in ptrtyps, the form
+   searched and the output findtheinfo() would have returned, and can
+   return non-zero to stop.  The base forms and index entries are
+   looked up, and the synset of each sense read, once for all of the
+   searches.  Returns the number of senses printed, or -1 if out of
+   memory. */
+
+int wn_searches(char *searchstr, int dbase, int *ptrtyps, int nsearch,
+		int whichsense, int (*func)(int, char *, char *, void *),
+		void *arg)
+{
+    struct wordform *forms = NULL;
+    char *morph_word;
+    int nforms = 0, maxforms = 0, i, f, total = 0, stop = 0;
+    void *p;
+    WNTRACE_BEGIN(span);
+
+    wn_stats_reset(WNSTATS_QUERY);
+
+    /* Find the base forms before looking up any index entries, as
+       morphstr() uses getindex() */
+
+    for (morph_word = searchstr; morph_word != NULL;
+	 morph_word = morphstr(nforms == 1 ? searchstr : NULL, dbase)) {
+	if (nforms == maxforms) {
+	    maxforms = maxforms ? maxforms * 2 : 4;
+	    if ((p = realloc(forms, maxforms * sizeof(struct wordform))) == NULL) {
+		free(forms);
+		return(-1);
+	    }
+	    WNSTAT(allocs, 1);
+	    forms = p;
+	}
+	snprintf(forms[nforms].word, WORDBUF, "%s", morph_word);
+	forms[nforms++].nidx = 0;
+    }
+    for (f = 0; f < nforms; f++)
+	resolve_form(&forms[f], forms[f].word, dbase);
+
+    for (i = 0; i < nsearch && !stop; i++)
+	for (f = 0; f < nforms && !stop; f++) {
+	    switch (ptrtyps[i]) {
+	    case OVERVIEW:
+	    case FREQ:
+	    case WNGREP:
+	    case RELATIVES:
+	    case VERBGROUP:
+		findtheinfo(forms[f].word, dbase, ptrtyps[i], whichsense);
+		break;
+	    default:
+		begin_search();
+		search_form(&forms[f], dbase, ptrtyps[i], whichsense);
+		end_search();
+		break;
+	    }
+	    total += wnresults.printcnt;
+	    stop = func(i, forms[f].word, searchbuffer, arg);
+	}
+
+    for (f = 0; f < nforms; f++)
+	free_form(&forms[f]);
+    free(forms);
+    WNTRACE_END(span, "wn_searches");
+    return(total);
+}
+
 /* Do requested search on synset passed, returning output in buffer. */
 
 char *do_trace(SynsetPtr synptr, int ptrtyp, int dbase, int depth)
 {
-    searchbuffer[0] = '\0';	/* clear output buffer */
+    truncbuffer(0);		/* clear output buffer */
     traceptrs(synptr, ptrtyp, dbase, depth);
     return(searchbuffer);
 }
@@ -1954,6 +2945,17 @@ static int HasHoloMero(IndexPtr index, int ptrtyp)
     int ptrbase;
 
     ptrbase = (ptrtyp == HMERONYM) ? HASMEMBERPTR : ISMEMBERPTR;
+
+    if (wn_graph_ready()) {
+	for (i = 0; i < index->off_cnt; i++) {
+	    if ((j = wn_graph_holomero(index->offset[i], ptrbase)) < 0)
+		break;
+	    found += j;
+	}
+	if (i == index->off_cnt)
+	    return(found);
+	found = 0;
+    }
     
     for(i = 0; i < index->off_cnt; i++) {
 	synset = read_synset(NOUN, index->offset[i], "");
@@ -2004,15 +3006,21 @@ unsigned int in_wn(char *word, int pos)
 static int depthcheck(int depth, SynsetPtr synptr)
 {
     if(depth >= MAXDEPTH) {
-	sprintf(msgbuf,
-		"WordNet library error: Error Cycle detected\n   %s\n",
-		synptr->words[0]);
-	display_message(msgbuf);
+	cycle_error(synptr);
 	depth = -1;		/* reset to get one more trace then quit */
     }
     return(depth);
 }
 
+static void cycle_error(SynsetPtr synptr)
+{
+    ncycles++;
+    sprintf(msgbuf,
+	    "WordNet library error: Error Cycle detected\n   %s\n",
+	    synptr->words[0]);
+    display_message(msgbuf);
+}
+
 /* Strip off () enclosed comments from a word */
 
 static char *deadjify(char *word)
@@ -2233,13 +3241,31 @@ static char *printant(int dbase, SynsetPtr synptr, int wdnum, char *template, ch
 }
 
 static void printbuffer(char *string)
+{
+    printbytes(string, strlen(string));
+}
+
+/* Append n bytes of string to searchbuffer, unless they don't all fit */
+
+static void printbytes(char *string, long n)
 {
     if (overflag)
 	return;
-    if (strlen(searchbuffer) + strlen(string) >= SEARCHBUF)
+    WNTRACE_BEGIN(span);
+    if (searchlen + n >= SEARCHBUF)
         overflag = 1;
-    else 
-	append_str(searchbuffer, sizeof(searchbuffer), string);
+    else {
+	memcpy(searchbuffer + searchlen, string, n);
+	searchlen += n;
+	searchbuffer[searchlen] = '\0';
+    }
+    WNTRACE_END(span, "printbuffer");
+}
+
+static void truncbuffer(long len)
+{
+    searchbuffer[len] = '\0';
+    searchlen = len;
 }
 
 static void printsns(SynsetPtr synptr, int sense)
@@ -0,0 +1,246 @@
+/*
+
+   wnderiv.c - derivationally related lemmas across parts of speech
+
+   The first call to wn_derivations() goes through the derivation
+   pointers of every synset in the in-memory pointer graph.  It reads
+   each synset with such pointers once, keeping the lemma and sense
+   number of each of its words, and records a link from the word each
+   pointer starts from to the word it leads to.  The links are sorted
+   by the lemma they start from, so all the lemmas derivationally
+   related to a word, in any part of speech, are one binary search and
+   a run of consecutive links away.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wn.h"
+
+#define EDGEBUF		64
+#define NOWORD		0xffffffffU
+
+/* Word of a synset: its lemma in the pool, and its sense number */
+struct dword {
+    unsigned int lemma;
+    unsigned int sense;
+};
+
+/* Derivation pointer from one word to another, as indexes into words */
+struct link {
+    unsigned int from, to;
+    unsigned char frompos, topos;
+};
+
+static char *pool;		/* lemmas, each ending in '\0' */
+static long poollen, poolsize;
+static struct dword *words;
+static long nwords, maxwords;
+static unsigned int *firstword;	/* first word of each synset read */
+static unsigned char *wcount;	/* number of words of each */
+static struct link *links;
+static long nlinks, maxlinks;
+static int built, failed;
+
+/* Read the words of synset id unless that's been done.  Returns -1 if
+   out of memory. */
+
+static int read_words(WnId id)
+{
+    SynsetPtr synptr;
+    char lemma[WORDBUF];
+    long len;
+    int i;
+    void *p;
+
+    if (firstword[id] != NOWORD)
+	return(0);
+    if ((synptr = read_synset(wn_id_pos(id), wn_id_offset(id), "")) == NULL)
+	return(-1);
+    firstword[id] = nwords;
+    wcount[id] = synptr->wcount < 255 ? synptr->wcount : 255;
+    for (i = 0; i < wcount[id]; i++) {
+	snprintf(lemma, sizeof(lemma), "%s", synptr->words[i]);
+	strsubst(lemma, ' ', '_');
+	strtolower(lemma);
+	len = strlen(lemma) + 1;
+	if (poollen + len > poolsize) {
+	    poolsize = poolsize ? poolsize * 2 : 65536;
+	    if ((p = realloc(pool, poolsize)) == NULL) {
+		free_synset(synptr);
+		return(-1);
+	    }
+	    pool = p;
+	}
+	if (nwords == maxwords) {
+	    maxwords = maxwords ? maxwords * 2 : 4096;
+	    if ((p = realloc(words, maxwords * sizeof(struct dword))) == NULL) {
+		free_synset(synptr);
+		return(-1);
+	    }
+	    words = p;
+	}
+	memcpy(pool + poollen, lemma, len);
+	words[nwords].lemma = poollen;
+	words[nwords++].sense = synptr->wnsns[i];
+	poollen += len;
+    }
+    free_synset(synptr);
+    return(0);
+}
+
+static int linkcmp(const void *a, const void *b)
+{
+    const struct link *x = a, *y = b;
+    int cmp;
+
+    if ((cmp = strcmp(pool + words[x->from].lemma,
+		      pool + words[y->from].lemma)) != 0)
+	return(cmp);
+    if (x->frompos != y->frompos)
+	return(x->frompos - y->frompos);
+    if (words[x->from].sense != words[y->from].sense)
+	return(words[x->from].sense < words[y->from].sense ? -1 : 1);
+    if (x->topos != y->topos)
+	return(x->topos - y->topos);
+    if ((cmp = strcmp(pool + words[x->to].lemma,
+		      pool + words[y->to].lemma)) != 0)
+	return(cmp);
+    if (words[x->to].sense != words[y->to].sense)
+	return(words[x->to].sense < words[y->to].sense ? -1 : 1);
+    return(0);
+}
+
+/* Read the derivation pointers of every synset.  Returns -1 if the
+   graph can't be loaded or memory runs out. */
+
+static int build_links(void)
+{
+    WnEdge buf[EDGEBUF], *edges;
+    long n, id, i, j;
+    int cnt;
+    void *p;
+
+    if (wn_graph_load() != 0)
+	return(-1);
+    n = wn_synset_count();
+    firstword = malloc(n * sizeof(unsigned int));
+    wcount = malloc(n);
+    WNSTAT(allocs, 2);
+    if (firstword == NULL || wcount == NULL)
+	return(-1);
+    memset(firstword, 0xff, n * sizeof(unsigned int));
+
+    for (id = 0; id < n; id++) {
+	edges = buf;
+	if ((cnt = wn_id_ptrs(id, DERIVATION, edges, EDGEBUF)) > EDGEBUF) {
+	    if ((edges = malloc(cnt * sizeof(WnEdge))) == NULL)
+		return(-1);
+	    cnt = wn_id_ptrs(id, DERIVATION, edges, cnt);
+	}
+	for (j = 0; j < cnt; j++) {
+	    if (edges[j].id == WN_NOID || edges[j].pfrm == 0 ||
+		edges[j].pto == 0)
+		continue;
+	    if (read_words(id) != 0 || read_words(edges[j].id) != 0)
+		break;
+	    if (edges[j].pfrm > wcount[id] ||
+		edges[j].pto > wcount[edges[j].id])
+		continue;
+	    if (nlinks == maxlinks) {
+		maxlinks = maxlinks ? maxlinks * 2 : 4096;
+		if ((p = realloc(links, maxlinks * sizeof(struct link))) == NULL)
+		    break;
+		links = p;
+	    }
+	    links[nlinks].from = firstword[id] + edges[j].pfrm - 1;
+	    links[nlinks].to = firstword[edges[j].id] + edges[j].pto - 1;
+	    links[nlinks].frompos = wn_id_pos(id);
+	    links[nlinks++].topos = edges[j].pos;
+	}
+	if (edges != buf)
+	    free(edges);
+	if (j < cnt)
+	    return(-1);
+    }
+
+    /* The same two senses may be linked by more than one pointer */
+    qsort(links, nlinks, sizeof(struct link), linkcmp);
+    for (i = j = 0; i < nlinks; i++)
+	if (j == 0 || linkcmp(&links[j - 1], &links[i]) != 0)
+	    links[j++] = links[i];
+    nlinks = j;
+    return(0);
+}
+
+/* Free the derivation links */
+
+void wn_derivations_free(void)
+{
+    free(pool);
+    free(words);
+    free(firstword);
+    free(wcount);
+    free(links);
+    pool = NULL;
+    words = NULL;
+    firstword = NULL;
+    wcount = NULL;
+    links = NULL;
+    poollen = poolsize = nwords = maxwords = nlinks = maxlinks = 0;
+    built = failed = 0;
+}
+
+/* Store up to max of the lemmas derivationally related to senses of
+   word, in any part of speech, in derivs, sorted by the part of speech
+   and sense of word they are related to.  Returns the number there
+   are, or -1 if the derivation pointers can't be loaded. */
+
+int wn_derivations(const char *word, WnDeriv *derivs, int max)
+{
+    char lemma[WORDBUF];
+    long lo, hi, mid;
+    int count = 0;
+    struct link *l;
+
+    if (!built) {
+	if (failed || legacyflag)
+	    return(-1);
+	if (build_links() != 0) {
+	    wn_derivations_free();
+	    failed = 1;
+	    return(-1);
+	}
+	built = 1;
+    }
+
+    snprintf(lemma, sizeof(lemma), "%s", word);
+    strsubst(lemma, ' ', '_');
+    ToLowerCase(lemma);
+
+    /* Find the first link from lemma */
+    lo = 0;
+    hi = nlinks;
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (strcmp(pool + words[links[mid].from].lemma, lemma) < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+
+    for (l = links + lo;
+	 l < links + nlinks && !strcmp(pool + words[l->from].lemma, lemma);
+	 l++) {
+	if (count < max) {
+	    derivs[count].lemma = pool + words[l->to].lemma;
+	    derivs[count].pos = l->topos;
+	    derivs[count].sense = words[l->to].sense;
+	    derivs[count].frompos = l->frompos;
+	    derivs[count].fromsense = words[l->from].sense;
+	}
+	count++;
+    }
+    return(count);
+}
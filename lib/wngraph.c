@@ -0,0 +1,1300 @@
+/*
+
+   wngraph.c - in-memory pointer graph
+
+   The pointers of every synset are loaded into arrays in compressed
+   sparse row form.  Synsets are numbered densely, nouns first, then
+   verbs, adjectives and adverbs, each in order of offset, and these
+   numbers are the synset ids of the public interface.  A hash table
+   maps part of speech and offset back to the id.  The
+   pointers from synset i are edges edgestart[i] to edgestart[i+1] - 1,
+   in the order they appear in the data file, and the pointers to it
+   are listed the same way through revstart and revedge.  Following a
+   relation is then a walk over a few arrays, with no file reads or
+   parsing.
+
+   Once the whole graph is loaded, is-a queries are answered from a
+   labelling of the hypernym hierarchies.  A breadth first search down
+   from the tops gives each synset its depth and a parent on a shortest
+   path to the top, and numbering the resulting spanning tree in pre-
+   order gives every synset an interval, prenum to lastnum, holding the
+   numbers of the synsets below it in the tree.  Where a synset and all
+   those above it have just that one hypernym, the interval test alone
+   says whether it is below another; otherwise its other hypernyms are
+   searched as well.  The synsets below one are listed from the same
+   numbering: those in its interval, then for each hypernym pointer off
+   the tree from a synset below it, the interval of the pointer's source.
+
+   Shortest paths between two synsets through any chosen pointer types
+   are found by breadth first search from both ends at once, the
+   backward search following the reverse edges.
+
+   For each noun synset we also record which member, substance and
+   part pointers it has, and which of them it or any of its hypernyms
+   have, which is all HasHoloMero() needs.  A hierarchical meronym
+   search prints a line for each hypernym reached depth first from the
+   noun, then the meronyms of that hypernym, and finally cuts off
+   whatever follows the last of those, so most of the hypernym lines
+   don't stay in the output.  The lines that do are listed for each
+   noun in another set of compressed sparse row arrays, inhstart and
+   inhlist, each with its depth and the pointer types that keep it.  A
+   noun's list is its own line followed by the lists of its hypernyms
+   in pointer order, so the lists are built from the top of the
+   hierarchy down.
+
+   The arrays are built from the memory mapped data files.  That takes
+   longer than a handful of searches, so unless wn_graph_load() is
+   called only the nouns are loaded, once a process has made GRAPHUSES
+   hierarchical searches.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wn.h"
+
+#define GRAPHUSES	32	/* searches made before graph is built */
+
+#define MASKBITS	6	/* ISMEMBERPTR ... HASPARTPTR */
+#define NOSKIP		(1 << MASKBITS)	/* cycle or pointer from one word */
+#define MAXINHERIT	1024	/* longest list of inherited lines */
+
+static long nsyns;		/* synsets of all parts of speech */
+static long posbase[NUMPARTS + 2]; /* number of first synset of each */
+static long *offsets;		/* offset of each, ascending within pos */
+static long *edgestart;		/* nsyns + 1 entries */
+static unsigned int *idtable;	/* synset numbers, hashed by offset */
+static unsigned long idmask;	/* size of idtable - 1 */
+static unsigned int *edgeto;	/* synset number of target */
+static unsigned char *edgetype;	/* pointer type */
+static unsigned char *edgefrm;	/* source word number, 0 for synset */
+static unsigned char *edgewd;	/* target word number, 0 for synset */
+static long *revstart;		/* nsyns + 1 entries */
+static unsigned int *revedge;	/* edges to each synset, by source */
+static unsigned int *revfrom;	/* source synset of each of them */
+
+static unsigned char *ownmask;	/* pointers of noun, bit per type */
+static unsigned short *inherit;	/* pointers of noun and hypernyms */
+static long *inhstart;		/* nnouns + 1 entries */
+
+struct inherited {
+    unsigned int synset;	/* hypernym printed */
+    unsigned char depth;	/* hypernyms from the noun to it */
+    unsigned char types;	/* pointer types whose searches keep it */
+};
+static struct inherited *inhlist;
+static unsigned int *prenum;	/* pre-order number in spanning tree */
+static unsigned int *lastnum;	/* largest number below it */
+static unsigned int *treeroot;	/* top of its tree */
+static unsigned short *mindepth; /* fewest hypernyms to the top */
+static unsigned char *multi;	/* has hypernyms off its tree path */
+static int maxdepth[NUMPARTS + 1]; /* greatest mindepth of each pos */
+static unsigned int *order;	/* synset with each pre-order number */
+static unsigned int *excpre;	/* pre-order number of hypernym ... */
+static unsigned int *excfrom;	/* ... of synset off its tree path */
+static long nexc;
+static unsigned int *seen;	/* generation synset was last visited */
+static unsigned int *upstack;	/* synsets to visit */
+static unsigned int seengen;
+
+struct span {
+    unsigned int first, last;	/* pre-order numbers */
+};
+static struct span *spans;	/* intervals of synsets to list */
+static long nspans, maxspans;
+
+/* How a path search reached a synset from one end: the synset next to
+   it on the way to that end, the edge between them and its distance */
+struct reach {
+    unsigned int gen;
+    unsigned int link;
+    unsigned int edge;
+    unsigned int dist;
+};
+
+static struct reach *fwd, *bwd;	/* reached from start and from goal */
+static unsigned int *fqueue, *bqueue;
+static unsigned int pathgen;
+
+static int loaded;		/* last part of speech loaded */
+static int uses, failed;
+
+static unsigned char symtype[128][128];	/* pointer type of each symbol */
+
+#define IDHASH(pos, offset) \
+    ((((unsigned long)(offset) * 4 + (pos)) * 2654435761UL >> 8) & idmask)
+
+/* Return number of synset at offset in pos, or -1 */
+
+static long synset_number(int pos, long offset)
+{
+    unsigned long h;
+    unsigned int n;
+
+    if (pos < 1 || pos > NUMPARTS || idtable == NULL)
+	return(-1);
+    for (h = IDHASH(pos, offset); (n = idtable[h]) != WN_NOID;
+	 h = (h + 1) & idmask)
+	if (offsets[n] == offset && n >= posbase[pos] && n < posbase[pos + 1])
+	    return((long)n);
+    return(-1);
+}
+
+/* Hash the numbers of all synsets by part of speech and offset */
+
+static int build_idtable(void)
+{
+    unsigned long size, h;
+    long n;
+    int pos;
+
+    for (size = 64; size < 2 * (unsigned long)nsyns; size *= 2)
+	;
+    if ((idtable = malloc(size * sizeof(unsigned int))) == NULL)
+	return(-1);
+    WNSTAT(allocs, 1);
+    memset(idtable, 0xff, size * sizeof(unsigned int));
+    idmask = size - 1;
+    for (pos = 1; pos <= NUMPARTS; pos++)
+	for (n = posbase[pos]; n < posbase[pos + 1]; n++) {
+	    for (h = IDHASH(pos, offsets[n]); idtable[h] != WN_NOID;
+		 h = (h + 1) & idmask)
+		;
+	    idtable[h] = n;
+	}
+    return(0);
+}
+
+static int synset_pos(long n)
+{
+    int pos;
+
+    for (pos = 1; pos < NUMPARTS && n >= posbase[pos + 1]; pos++)
+	;
+    return(pos);
+}
+
+static char *skipfield(char *p)
+{
+    while (*p == ' ')
+	p++;
+    while (*p != ' ' && *p != '\n')
+	p++;
+    return(p);
+}
+
+static int hexdigit(int c)
+{
+    if (c >= '0' && c <= '9')
+	return(c - '0');
+    if (c >= 'a' && c <= 'f')
+	return(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F')
+	return(c - 'A' + 10);
+    return(0);
+}
+
+/* Fill in symtype from the pointer symbols in ptrtyp[] */
+
+static void init_symtype(void)
+{
+    int i;
+    unsigned char *sym;
+
+    for (i = MAXPTR; i > 0; i--) {
+	sym = (unsigned char *)ptrtyp[i];
+	if (sym[0] < 128 && sym[0] && (sym[1] == '\0' || sym[2] == '\0'))
+	    symtype[sym[0]][sym[1] & 127] = i;
+    }
+}
+
+/* Parse the pointers of the synset on line p, storing their targets
+   as offsets and parts of speech in tgtoff and tgtpos until they can
+   be numbered. */
+
+static char *parse_line(char *p, long n, long *nedges,
+			long *tgtoff, unsigned char *tgtpos)
+{
+    long wcnt, pcnt, e;
+    int i;
+
+    offsets[n] = strtol(p, &p, 10);
+    p = skipfield(p);		/* lexicographer file */
+    p = skipfield(p);		/* synset type */
+    wcnt = strtol(p, &p, 16);
+    for (i = 0; i < 2 * wcnt; i++)
+	p = skipfield(p);	/* word and lex_id */
+    pcnt = strtol(p, &p, 10);
+
+    for (i = 0; i < pcnt; i++) {
+	e = (*nedges)++;
+	while (*p == ' ')
+	    p++;
+	if ((p[0] & 0x80) || (p[1] != ' ' && p[2] != ' ') || (p[1] & 0x80))
+	    edgetype[e] = 0;
+	else
+	    edgetype[e] = symtype[(int)p[0]][p[1] == ' ' ? 0 : (int)p[1]];
+	p = skipfield(p);	/* pointer symbol */
+	tgtoff[e] = strtol(p, &p, 10);
+	while (*p == ' ')
+	    p++;
+	switch (*p) {
+	case 'n': tgtpos[e] = NOUN; break;
+	case 'v': tgtpos[e] = VERB; break;
+	case 'a': case 's': tgtpos[e] = ADJ; break;
+	case 'r': tgtpos[e] = ADV; break;
+	default: tgtpos[e] = 0; break;
+	}
+	p = skipfield(p);
+	while (*p == ' ')
+	    p++;
+	edgefrm[e] = hexdigit(p[0]) * 16 + hexdigit(p[1]);
+	edgewd[e] = hexdigit(p[2]) * 16 + hexdigit(p[3]);
+	p = skipfield(p);	/* source/target */
+    }
+    edgestart[n + 1] = *nedges;
+    return(p);
+}
+
+/* Return number of noun that noun edge e is a hypernym pointer to,
+   -1 if it's another type of pointer, or -2 if the hypernym isn't a
+   known noun. */
+
+static long hypernym(long e)
+{
+    if (edgetype[e] != HYPERPTR)
+	return(-1);
+    if (edgeto[e] == WN_NOID || edgeto[e] >= posbase[NOUN + 1])
+	return(-2);
+    return((long)edgeto[e]);
+}
+
+/* Fill in inherit for noun n and its hypernyms, depth first with an
+   explicit stack, adding each to done[] once its hypernyms are.  state
+   is 0 for synsets not reached yet, 1 while their hypernyms are being
+   done, and 2 after. */
+
+static void propagate(long n, unsigned char *state, long *stack, long *next,
+		      long *done, long *ndone)
+{
+    long sp = 0, s, h, e;
+
+    stack[sp] = n;
+    next[sp++] = edgestart[n];
+    state[n] = 1;
+    while (sp > 0) {
+	s = stack[sp - 1];
+	if (next[sp - 1] < edgestart[s + 1]) {
+	    e = next[sp - 1]++;
+	    if ((h = hypernym(e)) == -1)
+		continue;
+	    if (h < 0 || edgefrm[e])
+		inherit[s] |= NOSKIP;
+	    if (h < 0)
+		continue;
+	    if (state[h] == 1)
+		inherit[s] |= NOSKIP;	/* cycle */
+	    else if (state[h] == 0) {
+		stack[sp] = h;
+		next[sp++] = edgestart[h];
+		state[h] = 1;
+	    }
+	    continue;
+	}
+
+	inherit[s] |= ownmask[s];
+	for (e = edgestart[s]; e < edgestart[s + 1]; e++)
+	    if ((h = hypernym(e)) >= 0)
+		inherit[s] |= inherit[h];
+	done[(*ndone)++] = s;
+	state[s] = 2;
+	sp--;
+    }
+}
+
+/* List the hypernym lines a hierarchical search of each noun keeps,
+   taking the nouns in the order of done[], hypernyms first.  The line
+   of a hypernym is kept if a holonym or meronym is printed before the
+   search next cuts off its output, which it does after the last
+   hypernym above each synset.  So it is kept for the types that it,
+   its first hypernym, that one's first hypernym and so on up to the
+   top have; chain holds them.  No list is made for nouns with NOSKIP
+   set, or whose list would be too long. */
+
+static int build_inherited(long *done, long ndone, unsigned char *chain)
+{
+    long i, s, h, e, k, p, nnouns = posbase[NOUN + 1];
+    int first;
+
+    inhstart = calloc(nnouns + 1, sizeof(long));
+    WNSTAT(allocs, 1);
+    if (inhstart == NULL)
+	return(-1);
+
+    /* Count the lines of each list in inhstart[s + 1] */
+    for (i = 0; i < ndone; i++) {
+	s = done[i];
+	for (e = edgestart[s]; e < edgestart[s + 1]; e++)
+	    if ((h = hypernym(e)) >= 0 && (inherit[h] & NOSKIP))
+		inherit[s] |= NOSKIP;
+	if (inherit[s] & NOSKIP)
+	    continue;
+	chain[s] = ownmask[s];
+	k = 0;
+	first = 1;
+	for (e = edgestart[s]; e < edgestart[s + 1]; e++) {
+	    if ((h = hypernym(e)) < 0)
+		continue;
+	    if (first)
+		chain[s] |= chain[h];
+	    first = 0;
+	    k += inhstart[h + 1];
+	}
+	k += chain[s] != 0;
+	if (k > MAXINHERIT)
+	    inherit[s] |= NOSKIP;
+	else
+	    inhstart[s + 1] = k;
+    }
+    for (s = 0; s < nnouns; s++)
+	inhstart[s + 1] += inhstart[s];
+
+    inhlist = malloc((inhstart[nnouns] + 1) * sizeof(struct inherited));
+    WNSTAT(allocs, 1);
+    if (inhlist == NULL)
+	return(-1);
+    for (i = 0; i < ndone; i++) {
+	s = done[i];
+	if (inherit[s] & NOSKIP)
+	    continue;
+	p = inhstart[s];
+	if (chain[s]) {
+	    inhlist[p].synset = s;
+	    inhlist[p].depth = 0;
+	    inhlist[p++].types = chain[s];
+	}
+	for (e = edgestart[s]; e < edgestart[s + 1]; e++) {
+	    if ((h = hypernym(e)) < 0)
+		continue;
+	    for (k = inhstart[h]; k < inhstart[h + 1]; k++) {
+		inhlist[p] = inhlist[k];
+		inhlist[p++].depth++;
+	    }
+	}
+    }
+    return(0);
+}
+
+/* Work out the member, substance and part pointers each noun and its
+   hypernyms have */
+
+static int build_hierarchy(void)
+{
+    long n, e, ndone = 0, nnouns = posbase[NOUN + 1];
+    unsigned char *state;
+    long *stack, *next, *done;
+    int err;
+
+    ownmask = calloc(nnouns + 1, 1);
+    inherit = calloc(nnouns + 1, sizeof(unsigned short));
+    state = calloc(nnouns + 1, 1);
+    stack = malloc((nnouns + 1) * sizeof(long));
+    next = malloc((nnouns + 1) * sizeof(long));
+    done = malloc((nnouns + 1) * sizeof(long));
+    WNSTAT(allocs, 6);
+    if (!ownmask || !inherit || !state || !stack || !next || !done) {
+	free(state);
+	free(stack);
+	free(next);
+	free(done);
+	return(-1);
+    }
+
+    for (n = 0; n < nnouns; n++)
+	for (e = edgestart[n]; e < edgestart[n + 1]; e++)
+	    if (edgetype[e] >= ISMEMBERPTR && edgetype[e] <= HASPARTPTR)
+		ownmask[n] |= 1 << (edgetype[e] - ISMEMBERPTR);
+    for (n = 0; n < nnouns; n++)
+	if (state[n] == 0)
+	    propagate(n, state, stack, next, done, &ndone);
+
+    /* state is all 2 now; clear it to hold the chain types */
+    memset(state, 0, nnouns + 1);
+    err = build_inherited(done, ndone, state);
+
+    free(state);
+    free(stack);
+    free(next);
+    free(done);
+    return(err);
+}
+
+/* List the edges to each synset, in order of source */
+
+static int build_reverse(long nedges)
+{
+    long n, e;
+
+    revstart = calloc(nsyns + 2, sizeof(long));
+    revedge = malloc((nedges + 1) * sizeof(unsigned int));
+    revfrom = malloc((nedges + 1) * sizeof(unsigned int));
+    WNSTAT(allocs, 3);
+    if (!revstart || !revedge || !revfrom)
+	return(-1);
+
+    for (e = 0; e < nedges; e++)
+	if (edgeto[e] != WN_NOID)
+	    revstart[edgeto[e] + 2]++;
+    for (n = 0; n < nsyns; n++)
+	revstart[n + 2] += revstart[n + 1];
+    for (n = 0; n < nsyns; n++)
+	for (e = edgestart[n]; e < edgestart[n + 1]; e++)
+	    if (edgeto[e] != WN_NOID) {
+		revfrom[revstart[edgeto[e] + 1]] = n;
+		revedge[revstart[edgeto[e] + 1]++] = e;
+	    }
+    return(0);
+}
+
+/* Build the graph from the data files of parts of speech up to
+   lastpos.  Pointers to synsets of the others are left unknown. */
+
+static int build_graph(int lastpos)
+{
+    char *base[NUMPARTS + 1], *p, *end;
+    long size[NUMPARTS + 1], nlines, maxedges, nedges, n, e;
+    long *tgtoff;
+    unsigned char *tgtpos;
+    int pos;
+
+    init_symtype();
+
+    /* Every synset takes a line, and every pointer more than 16 bytes */
+    nlines = maxedges = 0;
+    for (pos = 1; pos <= lastpos; pos++) {
+	if ((base[pos] = wn_mapped(datafps[pos], &size[pos])) == NULL)
+	    return(-1);
+	end = base[pos] + size[pos];
+	for (p = base[pos]; p < end && (p = memchr(p, '\n', end - p)); p++)
+	    nlines++;
+	maxedges += size[pos] / 16;
+    }
+    offsets = malloc((nlines + 1) * sizeof(long));
+    edgestart = malloc((nlines + 1) * sizeof(long));
+    edgeto = malloc((maxedges + 1) * sizeof(unsigned int));
+    edgetype = malloc(maxedges + 1);
+    edgefrm = malloc(maxedges + 1);
+    edgewd = malloc(maxedges + 1);
+    tgtoff = malloc((maxedges + 1) * sizeof(long));
+    tgtpos = malloc(maxedges + 1);
+    WNSTAT(allocs, 8);
+    if (!offsets || !edgestart || !edgeto || !edgetype || !edgefrm ||
+	!edgewd || !tgtoff || !tgtpos) {
+	free(tgtoff);
+	free(tgtpos);
+	return(-1);
+    }
+
+    edgestart[0] = nedges = n = 0;
+    for (pos = 1; pos <= NUMPARTS; pos++) {
+	posbase[pos] = n;
+	if (pos > lastpos)
+	    continue;
+	end = base[pos] + size[pos];
+	for (p = base[pos]; p < end; p++) {
+	    if (*p != ' ')	/* skip license */
+		p = parse_line(p, n++, &nedges, tgtoff, tgtpos);
+	    if ((p = memchr(p, '\n', end - p)) == NULL)
+		break;
+	}
+    }
+    posbase[NUMPARTS + 1] = nsyns = n;
+    loaded = lastpos;
+    if (build_idtable() != 0) {
+	free(tgtoff);
+	free(tgtpos);
+	return(-1);
+    }
+
+    for (e = 0; e < nedges; e++)
+	edgeto[e] = (n = synset_number(tgtpos[e], tgtoff[e])) < 0 ?
+	    WN_NOID : (unsigned int)n;
+    free(tgtoff);
+    free(tgtpos);
+
+    if (build_reverse(nedges) != 0 || build_hierarchy() != 0)
+	return(-1);
+    return(0);
+}
+
+static void free_closure(void)
+{
+    free(prenum);
+    free(lastnum);
+    free(treeroot);
+    free(mindepth);
+    free(multi);
+    free(order);
+    free(excpre);
+    free(excfrom);
+    free(seen);
+    free(upstack);
+    free(spans);
+    free(fwd);
+    free(bwd);
+    free(fqueue);
+    free(bqueue);
+    fwd = bwd = NULL;
+    fqueue = bqueue = NULL;
+    pathgen = 0;
+    prenum = lastnum = treeroot = order = excpre = excfrom = NULL;
+    seen = upstack = NULL;
+    mindepth = NULL;
+    multi = NULL;
+    spans = NULL;
+    nexc = nspans = maxspans = 0;
+    seengen = 0;
+    memset(maxdepth, 0, sizeof(maxdepth));
+}
+
+static void free_graph(void)
+{
+    free(offsets);
+    free(idtable);
+    free(edgestart);
+    free(edgeto);
+    free(edgetype);
+    free(edgefrm);
+    free(edgewd);
+    free(revstart);
+    free(revedge);
+    free(revfrom);
+    free(ownmask);
+    free(inherit);
+    free(inhstart);
+    free(inhlist);
+    free_closure();
+    offsets = edgestart = revstart = NULL;
+    idtable = edgeto = revedge = revfrom = NULL;
+    edgetype = edgefrm = edgewd = ownmask = NULL;
+    inherit = NULL;
+    inhstart = NULL;
+    inhlist = NULL;
+    nsyns = 0;
+    memset(posbase, 0, sizeof(posbase));
+    loaded = 0;
+}
+
+/* Load the pointers of all synsets now, however few searches have
+   been made, replacing the nouns alone if only they were loaded.
+   Returns 0, or -1 if the graph can't be built. */
+
+int wn_graph_load(void)
+{
+    if (loaded == NUMPARTS)
+	return(0);
+    if (legacyflag || failed)
+	return(-1);
+    free_graph();
+    if (build_graph(NUMPARTS) != 0) {
+	free_graph();
+	failed = 1;
+	return(-1);
+    }
+    return(0);
+}
+
+/* Return 1 if the noun hierarchy can be used, building it if this
+   process has made enough hierarchical searches for that to pay.
+   Only the noun data file is loaded for it. */
+
+int wn_graph_ready(void)
+{
+    if (loaded)
+	return(1);
+    if (legacyflag || failed || ++uses < GRAPHUSES)
+	return(0);
+    if (build_graph(NOUN) != 0) {
+	free_graph();
+	failed = 1;
+	return(0);
+    }
+    return(1);
+}
+
+void wn_graph_free(void)
+{
+    free_graph();
+    uses = failed = 0;
+}
+
+/* Copy the edges of type ptrtyp (or of any type if 0) in list[first]
+   to list[last - 1] into edges, at most max of them, as pointers to
+   their targets, or from their sources if reverse is set.  Returns
+   the number of edges of that type. */
+
+static int copy_edges(long first, long last, unsigned int *list,
+		      int reverse, int ptrtyp, WnEdge *edges, int max)
+{
+    long i, e, n;
+    int count = 0;
+
+    for (i = first; i < last; i++) {
+	e = list ? list[i] : i;
+	if (ptrtyp && edgetype[e] != ptrtyp)
+	    continue;
+	if (count < max) {
+	    n = reverse ? (long)revfrom[i] : (long)edgeto[e];
+	    edges[count].id = (WnId)n;
+	    edges[count].ptrtyp = edgetype[e];
+	    edges[count].pfrm = edgefrm[e];
+	    edges[count].pto = edgewd[e];
+	    if (edgeto[e] == WN_NOID) {
+		edges[count].pos = 0;
+		edges[count].offset = -1;
+	    } else {
+		edges[count].pos = synset_pos(n);
+		edges[count].offset = offsets[n];
+	    }
+	}
+	count++;
+    }
+    return(count);
+}
+
+/* Store up to max pointers of type ptrtyp (any type if 0) from the
+   synset at offset in pos into edges, in data file order.  Returns
+   the number of such pointers, or -1 if the graph isn't loaded or the
+   synset isn't in it. */
+
+int wn_graph_ptrs(int pos, long offset, int ptrtyp, WnEdge *edges, int max)
+{
+    long n;
+
+    if (loaded != NUMPARTS || (n = synset_number(pos, offset)) < 0)
+	return(-1);
+    return(copy_edges(edgestart[n], edgestart[n + 1], NULL, 0,
+		      ptrtyp, edges, max));
+}
+
+/* As wn_graph_ptrs(), for the pointers to the synset, with the source
+   synset of each in edges. */
+
+int wn_graph_refs(int pos, long offset, int ptrtyp, WnEdge *edges, int max)
+{
+    long n;
+
+    if (loaded != NUMPARTS || (n = synset_number(pos, offset)) < 0)
+	return(-1);
+    return(copy_edges(revstart[n], revstart[n + 1], revedge, 1,
+		      ptrtyp, edges, max));
+}
+
+/* Return the number of synsets in the loaded graph, which is one more
+   than the largest synset id, or 0 if wn_graph_load() hasn't been
+   called. */
+
+long wn_synset_count(void)
+{
+    return(loaded == NUMPARTS ? nsyns : 0);
+}
+
+/* Return id of the synset at offset in pos, or WN_NOID */
+
+WnId wn_synset_id(int pos, long offset)
+{
+    long n;
+
+    if (loaded != NUMPARTS || (n = synset_number(pos, offset)) < 0)
+	return(WN_NOID);
+    return((WnId)n);
+}
+
+/* Return part of speech of synset id, or 0 if there is no such id */
+
+int wn_id_pos(WnId id)
+{
+    if (loaded != NUMPARTS || id >= nsyns)
+	return(0);
+    return(synset_pos(id));
+}
+
+/* Return offset of synset id, or -1 if there is no such id */
+
+long wn_id_offset(WnId id)
+{
+    if (loaded != NUMPARTS || id >= nsyns)
+	return(-1);
+    return(offsets[id]);
+}
+
+/* As wn_graph_ptrs() and wn_graph_refs(), for synset id */
+
+int wn_id_ptrs(WnId id, int ptrtyp, WnEdge *edges, int max)
+{
+    if (loaded != NUMPARTS || id >= nsyns)
+	return(-1);
+    return(copy_edges(edgestart[id], edgestart[id + 1], NULL, 0,
+		      ptrtyp, edges, max));
+}
+
+int wn_id_refs(WnId id, int ptrtyp, WnEdge *edges, int max)
+{
+    if (loaded != NUMPARTS || id >= nsyns)
+	return(-1);
+    return(copy_edges(revstart[id], revstart[id + 1], revedge, 1,
+		      ptrtyp, edges, max));
+}
+
+#define UNREACHED	0xffff
+
+#define ISHYPER(e) \
+    ((edgetype[e] == HYPERPTR || edgetype[e] == INSTANCE) && \
+     edgeto[e] != WN_NOID)
+
+/* Number the spanning tree below root in pre-order, starting at num.
+   The children of a synset are those hyponyms it is the tree parent of,
+   found in its reverse edges.  Returns the next number. */
+
+static unsigned int number_tree(unsigned int root, unsigned int num,
+				unsigned int *parent, long *next)
+{
+    long sp = 0, i;
+    unsigned int x, s;
+
+    upstack[sp++] = root;
+    next[root] = revstart[root];
+    prenum[root] = num++;
+    while (sp > 0) {
+	x = upstack[sp - 1];
+	if ((i = next[x]) < revstart[x + 1]) {
+	    next[x]++;
+	    s = revfrom[i];
+	    if (parent[s] == x && ISHYPER(revedge[i]) && prenum[s] == WN_NOID) {
+		prenum[s] = num++;
+		next[s] = revstart[s];
+		upstack[sp++] = s;
+	    }
+	    continue;
+	}
+	lastnum[x] = num - 1;
+	sp--;
+    }
+    return(num);
+}
+
+/* Find depths and tree parents breadth first from the tops of the
+   hierarchies, then number the tree.  Where hypernyms form a cycle
+   with nothing above it, a synset in the cycle is made a top. */
+
+static int build_closure(void)
+{
+    unsigned int *parent, *queue, x, s, num, walk = 0;
+    unsigned char *nhyper;
+    long *next, head, tail, n, e, i;
+
+    prenum = malloc(nsyns * sizeof(unsigned int));
+    lastnum = malloc(nsyns * sizeof(unsigned int));
+    treeroot = malloc(nsyns * sizeof(unsigned int));
+    mindepth = malloc(nsyns * sizeof(unsigned short));
+    multi = malloc(nsyns);
+    seen = calloc(nsyns, sizeof(unsigned int));
+    upstack = malloc(nsyns * sizeof(unsigned int));
+    order = malloc(nsyns * sizeof(unsigned int));
+    parent = malloc(nsyns * sizeof(unsigned int));
+    queue = malloc(nsyns * sizeof(unsigned int));
+    nhyper = calloc(nsyns, 1);
+    next = malloc(nsyns * sizeof(long));
+    WNSTAT(allocs, 12);
+    if (!prenum || !lastnum || !treeroot || !mindepth || !multi || !seen ||
+	!upstack || !order || !parent || !queue || !nhyper || !next) {
+	free(parent);
+	free(queue);
+	free(nhyper);
+	free(next);
+	return(-1);
+    }
+
+    for (n = 0; n < nsyns; n++) {
+	parent[n] = prenum[n] = WN_NOID;
+	for (e = edgestart[n]; e < edgestart[n + 1]; e++)
+	    if (ISHYPER(e) && nhyper[n] < 255)
+		nhyper[n]++;
+    }
+
+    /* Breadth first down from each top, tops with no hypernyms first */
+    head = tail = 0;
+    for (n = 0; n < nsyns; n++) {
+	mindepth[n] = UNREACHED;
+	if (nhyper[n] == 0) {
+	    mindepth[n] = 0;
+	    treeroot[n] = n;
+	    queue[tail++] = n;
+	}
+    }
+    for (n = 0; ; ) {
+	while (head < tail) {
+	    x = queue[head++];
+	    for (i = revstart[x]; i < revstart[x + 1]; i++) {
+		s = revfrom[i];
+		if (!ISHYPER(revedge[i]) || mindepth[s] != UNREACHED)
+		    continue;
+		mindepth[s] = mindepth[x] + 1 < UNREACHED ?
+		    mindepth[x] + 1 : UNREACHED - 1;
+		parent[s] = x;
+		treeroot[s] = treeroot[x];
+		queue[tail++] = s;
+	    }
+	}
+	while (n < nsyns && mindepth[n] != UNREACHED)
+	    n++;
+	if (n == nsyns)
+	    break;
+
+	/* All above n are unreached too, so following hypernyms up from
+	   it goes round a cycle.  Make a synset in that the next top. */
+	walk++;
+	for (x = n; seen[x] != walk; x = edgeto[e]) {
+	    seen[x] = walk;
+	    for (e = edgestart[x]; !ISHYPER(e); e++)
+		;
+	}
+	mindepth[x] = 0;
+	treeroot[x] = x;
+	queue[tail++] = x;
+    }
+    memset(seen, 0, nsyns * sizeof(unsigned int));
+
+    for (n = 0; n < nsyns; n++)
+	if (mindepth[n] > maxdepth[synset_pos(n)])
+	    maxdepth[synset_pos(n)] = mindepth[n];
+
+    /* Parents come before children in the queue */
+    for (head = 0; head < tail; head++) {
+	x = queue[head];
+	multi[x] = nhyper[x] != (parent[x] != WN_NOID) ||
+	    (parent[x] != WN_NOID && multi[parent[x]]);
+    }
+
+    for (num = 0, n = 0; n < nsyns; n++)
+	if (parent[n] == WN_NOID)
+	    num = number_tree(n, num, parent, next);
+    for (n = 0; n < nsyns; n++)
+	order[prenum[n]] = n;
+
+    /* List the hypernym pointers off the tree in order of the number
+       of the hypernym, counting them for each number first */
+    memset(next, 0, nsyns * sizeof(long));
+    for (nexc = 0, n = 0; n < nsyns; n++)
+	for (e = edgestart[n]; e < edgestart[n + 1]; e++)
+	    if (ISHYPER(e) && edgeto[e] != parent[n]) {
+		next[prenum[edgeto[e]]]++;
+		nexc++;
+	    }
+    excpre = malloc((nexc + 1) * sizeof(unsigned int));
+    excfrom = malloc((nexc + 1) * sizeof(unsigned int));
+    WNSTAT(allocs, 2);
+    if (!excpre || !excfrom) {
+	free(parent);
+	free(queue);
+	free(nhyper);
+	free(next);
+	return(-1);
+    }
+    for (i = 0, n = 0; n < nsyns; n++) {
+	e = next[n];
+	next[n] = i;
+	i += e;
+    }
+    for (n = 0; n < nsyns; n++)
+	for (e = edgestart[n]; e < edgestart[n + 1]; e++)
+	    if (ISHYPER(e) && edgeto[e] != parent[n]) {
+		i = next[prenum[edgeto[e]]]++;
+		excpre[i] = prenum[edgeto[e]];
+		excfrom[i] = n;
+	    }
+
+    free(parent);
+    free(queue);
+    free(nhyper);
+    free(next);
+    return(0);
+}
+
+/* Return 1 if the is-a labelling can be used, building it the first
+   time it's needed once the whole graph is loaded */
+
+static int closure_ready(void)
+{
+    if (prenum)
+	return(1);
+    if (loaded != NUMPARTS)
+	return(0);
+    if (build_closure() != 0) {
+	free_closure();
+	return(0);
+    }
+    return(1);
+}
+
+/* Start a search up the hierarchy, returning the first of two
+   generations to mark synsets visited with */
+
+static unsigned int new_search(void)
+{
+    if (seengen >= 0xfffffffdU) {
+	memset(seen, 0, nsyns * sizeof(unsigned int));
+	seengen = 0;
+    }
+    seengen += 2;
+    return(seengen - 1);
+}
+
+#define BELOW(a, b)	(prenum[b] <= prenum[a] && prenum[a] <= lastnum[b])
+
+/* Return 1 if synset a is synset b, or a kind or instance of it
+   through any chain of hypernym and instance pointers, 0 if not, or
+   -1 if the graph isn't loaded or either id is unknown. */
+
+int wn_is_a(WnId a, WnId b)
+{
+    long sp = 0, e;
+    unsigned int x, h, gen;
+
+    if (!closure_ready() || a >= nsyns || b >= nsyns)
+	return(-1);
+    if (BELOW(a, b))
+	return(1);
+    if (!multi[a])
+	return(0);
+
+    /* Where a synset and all above it have only their tree parent as
+       hypernym, BELOW() has answered for them all */
+    gen = new_search();
+    seen[a] = gen;
+    upstack[sp++] = a;
+    while (sp > 0) {
+	x = upstack[--sp];
+	for (e = edgestart[x]; e < edgestart[x + 1]; e++) {
+	    if (!ISHYPER(e) || seen[h = edgeto[e]] == gen)
+		continue;
+	    seen[h] = gen;
+	    if (BELOW(h, b))
+		return(1);
+	    if (multi[h])
+		upstack[sp++] = h;
+	}
+    }
+    return(0);
+}
+
+static int add_span(unsigned int first, unsigned int last)
+{
+    struct span *p;
+
+    if (nspans == maxspans) {
+	p = realloc(spans, (maxspans + 64) * 2 * sizeof(struct span));
+	if (p == NULL)
+	    return(-1);
+	WNSTAT(allocs, 1);
+	spans = p;
+	maxspans = (maxspans + 64) * 2;
+    }
+    spans[nspans].first = first;
+    spans[nspans++].last = last;
+    return(0);
+}
+
+static int spancmp(const void *a, const void *b)
+{
+    const struct span *x = a, *y = b;
+
+    if (x->first != y->first)
+	return(x->first < y->first ? -1 : 1);
+    return(x->last > y->last ? -1 : x->last < y->last);
+}
+
+/* Call func with each synset below synset id through hypernym and
+   instance pointers, and arg, in pre-order of the spanning tree, until
+   func returns non-zero.  Returns the number of synsets func was called
+   with, or -1 if the graph isn't loaded or the id is unknown. */
+
+int wn_descendants(WnId id, int (*func)(WnId, void *), void *arg)
+{
+    long i, j, lo, hi, mid, count = 0;
+    unsigned int x, p, end, gen;
+
+    if (!closure_ready() || id >= nsyns)
+	return(-1);
+
+    /* The tree below id, and below each synset with a hypernym pointer
+       into it from off the tree.  Since any two of these intervals are
+       disjoint or one holds the other, those not inside an earlier one
+       are the synsets to list. */
+    gen = new_search();
+    seen[id] = gen;
+    nspans = 0;
+    if (add_span(prenum[id], lastnum[id]) != 0)
+	return(-1);
+    for (i = 0; i < nspans; i++) {
+	for (lo = 0, hi = nexc; lo < hi; ) {
+	    mid = (lo + hi) / 2;
+	    if (excpre[mid] < spans[i].first)
+		lo = mid + 1;
+	    else
+		hi = mid;
+	}
+	for (j = lo; j < nexc && excpre[j] <= spans[i].last; j++) {
+	    if (seen[x = excfrom[j]] == gen)
+		continue;
+	    seen[x] = gen;
+	    if (add_span(prenum[x], lastnum[x]) != 0)
+		return(-1);
+	}
+    }
+    qsort(spans, nspans, sizeof(struct span), spancmp);
+
+    for (i = 0, end = 0; i < nspans; i++) {
+	if (i > 0 && spans[i].first <= end)
+	    continue;
+	end = spans[i].last;
+	for (p = spans[i].first; p <= end; p++) {
+	    if (p == prenum[id])
+		continue;
+	    count++;
+	    if ((*func)(order[p], arg))
+		return(count);
+	}
+    }
+    return(count);
+}
+
+/* Return fewest hypernym and instance pointers from synset id to the
+   top of its hierarchy, or -1 if the graph isn't loaded or the id is
+   unknown */
+
+int wn_depth(WnId id)
+{
+    if (!closure_ready() || id >= nsyns)
+	return(-1);
+    return(mindepth[id]);
+}
+
+/* Return the greatest wn_depth() of any synset in pos, or -1 */
+
+int wn_max_depth(int pos)
+{
+    if (!closure_ready() || pos < 1 || pos > NUMPARTS)
+	return(-1);
+    return(maxdepth[pos]);
+}
+
+/* Store up to max of the tops of the hierarchies above synset id (or
+   the synset itself if it has no hypernyms) in roots, and return how
+   many there are, or -1 if the graph isn't loaded or the id is
+   unknown.  A synset whose hypernyms form a cycle with nothing above
+   it counts as a top. */
+
+int wn_roots(WnId id, WnId *roots, int max)
+{
+    long sp = 0, e;
+    unsigned int x, h, gen;
+    int count = 0;
+
+    if (!closure_ready() || id >= nsyns)
+	return(-1);
+    if (!multi[id]) {
+	if (max > 0)
+	    roots[0] = treeroot[id];
+	return(1);
+    }
+
+    /* Synsets visited are marked gen, tops counted gen + 1 */
+    gen = new_search();
+    seen[id] = gen;
+    upstack[sp++] = id;
+    while (sp > 0) {
+	x = upstack[--sp];
+	if (!multi[x] || treeroot[x] == x) {
+	    if (seen[h = treeroot[x]] != gen + 1) {
+		seen[h] = gen + 1;
+		if (count < max)
+		    roots[count] = h;
+		count++;
+	    }
+	    if (!multi[x])
+		continue;
+	}
+	for (e = edgestart[x]; e < edgestart[x + 1]; e++)
+	    if (ISHYPER(e) && seen[h = edgeto[e]] != gen &&
+		seen[h] != gen + 1) {
+		seen[h] = gen;
+		upstack[sp++] = h;
+	    }
+    }
+    return(count);
+}
+
+#define INMASK(mask, e)	((mask) == 0 || ((mask) >> edgetype[e] & 1))
+
+/* Expand one level of a path search, from queue[*head] to
+   queue[*tail - 1], through edges in mask from those synsets if
+   reverse is 0, or to them if it is set.  Each synset reached that the
+   search from the other end has also reached is a meeting point, and
+   the one giving the shortest path is stored in *meet, with its
+   length in *best. */
+
+static void expand(struct reach *near, struct reach *far, unsigned int *queue,
+		   long *head, long *tail, int reverse, unsigned long long mask,
+		   unsigned int *meet, unsigned int *best)
+{
+    long i, j, last = *tail, first, end;
+    unsigned int x, y, e;
+
+    for (i = *head; i < last; i++) {
+	x = queue[i];
+	first = reverse ? revstart[x] : edgestart[x];
+	end = reverse ? revstart[x + 1] : edgestart[x + 1];
+	for (j = first; j < end; j++) {
+	    if (reverse) {
+		e = revedge[j];
+		y = revfrom[j];
+	    } else if ((y = edgeto[e = j]) == WN_NOID)
+		continue;
+	    if (!INMASK(mask, e) || near[y].gen == pathgen)
+		continue;
+	    near[y].gen = pathgen;
+	    near[y].link = x;
+	    near[y].edge = e;
+	    near[y].dist = near[x].dist + 1;
+	    queue[(*tail)++] = y;
+	    if (far[y].gen == pathgen && near[y].dist + far[y].dist < *best) {
+		*best = near[y].dist + far[y].dist;
+		*meet = y;
+	    }
+	}
+    }
+    *head = last;
+}
+
+/* Find a shortest path from synset a to synset b through pointers of
+   the types in mask, a bit for each (1 << ptrtyp), or of any type if
+   mask is 0, of at most maxlen pointers if maxlen is positive.  The
+   search goes a level at a time from whichever end has fewer synsets
+   to visit next.  Stores up to max pointers of the path in edges, in
+   order from a, and returns its length, or -1 if there is no such
+   path or the graph isn't loaded. */
+
+int wn_path(WnId a, WnId b, unsigned long long mask, int maxlen,
+	    WnEdge *edges, int max)
+{
+    long fhead = 0, ftail = 0, bhead = 0, btail = 0;
+    unsigned int meet = WN_NOID, best = WN_NOID, limit, x;
+    int len, i;
+
+    if (loaded != NUMPARTS || a >= nsyns || b >= nsyns)
+	return(-1);
+    if (a == b)
+	return(0);
+    if (fwd == NULL) {
+	fwd = calloc(nsyns, sizeof(struct reach));
+	bwd = calloc(nsyns, sizeof(struct reach));
+	fqueue = malloc(nsyns * sizeof(unsigned int));
+	bqueue = malloc(nsyns * sizeof(unsigned int));
+	WNSTAT(allocs, 4);
+	if (!fwd || !bwd || !fqueue || !bqueue) {
+	    free(fwd);
+	    free(bwd);
+	    free(fqueue);
+	    free(bqueue);
+	    fwd = bwd = NULL;
+	    fqueue = bqueue = NULL;
+	    return(-1);
+	}
+    }
+    if (++pathgen == 0) {
+	memset(fwd, 0, nsyns * sizeof(struct reach));
+	memset(bwd, 0, nsyns * sizeof(struct reach));
+	pathgen = 1;
+    }
+    limit = maxlen > 0 ? (unsigned int)maxlen : WN_NOID - 1;
+
+    fwd[a].gen = bwd[b].gen = pathgen;
+    fwd[a].dist = bwd[b].dist = 0;
+    fqueue[ftail++] = a;
+    bqueue[btail++] = b;
+
+    /* Every path no longer than the distances searched so far from
+       both ends has been found once they add up to best */
+    while (fhead < ftail && bhead < btail &&
+	   fwd[fqueue[fhead]].dist + bwd[bqueue[bhead]].dist < limit &&
+	   fwd[fqueue[fhead]].dist + bwd[bqueue[bhead]].dist + 1 < best) {
+	if (ftail - fhead <= btail - bhead)
+	    expand(fwd, bwd, fqueue, &fhead, &ftail, 0, mask, &meet, &best);
+	else
+	    expand(bwd, fwd, bqueue, &bhead, &btail, 1, mask, &meet, &best);
+    }
+    if (meet == WN_NOID || best > limit)
+	return(-1);
+
+    len = best;
+    i = fwd[meet].dist;
+    for (x = meet; x != a; x = fwd[x].link)
+	if (--i < max)
+	    copy_edges(fwd[x].edge, fwd[x].edge + 1, NULL, 0, 0, &edges[i], 1);
+    i = fwd[meet].dist;
+    for (x = meet; x != b; x = bwd[x].link, i++)
+	if (i < max)
+	    copy_edges(bwd[x].edge, bwd[x].edge + 1, NULL, 0, 0, &edges[i], 1);
+    return(len);
+}
+
+/* Count the member, substance and part pointers (or holonym pointers
+   if ptrbase is ISMEMBERPTR) of the hypernyms of the noun at offset,
+   one for each type a hypernym has, as HasHoloMero() does.  Returns -1
+   if the synset isn't known. */
+
+int wn_graph_holomero(long offset, int ptrbase)
+{
+    long n, e, h;
+    int i, found = 0;
+
+    if ((n = synset_number(NOUN, offset)) < 0)
+	return(-1);
+    for (e = edgestart[n]; e < edgestart[n + 1]; e++) {
+	if ((h = hypernym(e)) == -1)
+	    continue;
+	if (h < 0)
+	    return(-1);
+	for (i = 0; i < 3; i++)
+	    if (ownmask[h] & (1 << (ptrbase + i - ISMEMBERPTR)))
+		found++;
+    }
+    return(found);
+}
+
+/* Find the next line, from entry i of the list of the noun at offset
+   on, that a hierarchical holonym (ptrbase ISMEMBERPTR) or meronym
+   (ptrbase HASMEMBERPTR) search keeps when it reaches the noun.  The
+   offset of the hypernym printed, which is the noun itself for the
+   first entry if that line is kept, and its depth above the noun are
+   stored in hyper and depth.  Returns the entry to go on from, 0 if
+   there are no more, or -1 if the list isn't known. */
+
+int wn_graph_inherited(long offset, int ptrbase, int i, long *hyper,
+		       int *depth)
+{
+    long n, k;
+    int mask = 7 << (ptrbase - ISMEMBERPTR);
+
+    if ((n = synset_number(NOUN, offset)) < 0 || (inherit[n] & NOSKIP))
+	return(-1);
+    for (k = inhstart[n] + i; k < inhstart[n + 1]; k++)
+	if (inhlist[k].types & mask) {
+	    *hyper = offsets[inhlist[k].synset];
+	    *depth = inhlist[k].depth;
+	    return(k - inhstart[n] + 1);
+	}
+    return(0);
+}
@@ -0,0 +1,313 @@
+/*
+
+   wnic.c - information content of synsets
+
+   wn_ic_build() adds up how many times the senses in each synset were
+   tagged, from cntlist.rev, plus one so that every synset has a count.
+   The frequency of a synset is its own count plus those of all the
+   synsets below it through hypernym and instance pointers, each taken
+   once, and its information content is -log(frequency / total), where
+   total is the sum of the counts of every synset of its part of
+   speech.  The table is written to a file, normally ic.dat in the
+   database directory, as a header followed by one double per synset
+   id.  wn_ic_load() maps the file into memory, so looking up the
+   information content of a synset is one array read.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "wn.h"
+
+#define ICMAGIC		0x43494e57	/* "WNIC" */
+#define ICVERSION	1
+
+/* Start of the file.  The database it was built from is identified by
+   the number of synsets and size of the data file of each part of
+   speech.  Its size is a multiple of 8 so the table is aligned. */
+struct icheader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int nsyns;
+    unsigned int npos[NUMPARTS + 1];
+    unsigned int datasize[NUMPARTS + 1];
+    unsigned int pad;
+};
+
+static double *ictable;		/* information content by synset id */
+static long icsyns;
+static FILE *icfp;		/* file mapped, or NULL */
+static char *icbuf;		/* file read in, if it couldn't be mapped */
+static char msgbuf[256];	/* buffer for constructing error messages */
+
+#define ICPATHBUF	512	/* search directory (at most 255) and file name */
+
+/* Store the name of the default file in path.  Returns -1 if it
+   doesn't fit. */
+
+static int default_file(char *path)
+{
+    int len = snprintf(path, ICPATHBUF, ICFILE, SetSearchdir());
+
+    if (len < 0 || len >= ICPATHBUF) {
+	display_message("WordNet library error: search directory name too long\n");
+	return(-1);
+    }
+    return(0);
+}
+
+/* Fill in the header describing the loaded database, or return -1 */
+
+static int describe(struct icheader *h)
+{
+    long n, size;
+    int pos;
+
+    memset(h, 0, sizeof(struct icheader));
+    h->magic = ICMAGIC;
+    h->version = ICVERSION;
+    if ((n = wn_synset_count()) == 0)
+	return(-1);
+    h->nsyns = n;
+    while (--n >= 0)
+	h->npos[wn_id_pos(n)]++;
+    for (pos = 1; pos <= NUMPARTS; pos++) {
+	if (wn_mapped(datafps[pos], &size) == NULL)
+	    return(-1);
+	h->datasize[pos] = size;
+    }
+    return(0);
+}
+
+static int addfreq(WnId id, void *arg)
+{
+    double **counts = arg;
+
+    counts[1][0] += counts[0][id];
+    return(0);
+}
+
+/* Return 1 if the synset at offset in the data file of pos is in
+   lexicographer file fnum and of synset type sstype */
+
+static int synset_matches(int pos, unsigned long offset, int fnum, int sstype)
+{
+    char *base, buf[32], type;
+    long size, len;
+    int num;
+
+    if ((base = wn_mapped(datafps[pos], &size)) == NULL ||
+	offset >= (unsigned long)size)
+	return(0);
+    len = size - offset < (long)sizeof(buf) ? size - offset : sizeof(buf) - 1;
+    memcpy(buf, base + offset, len);
+    buf[len] = '\0';
+    if (sscanf(buf, "%*u %d %c", &num, &type) != 2)
+	return(0);
+    return(num == fnum && getsstype(&type) == sstype);
+}
+
+/* Add count in line of cntlist.rev to the count of the synset the
+   sense belongs to.  The sense key gives the lemma and part of speech,
+   and the sense number the synset in its index entry, which must be in
+   the lexicographer file the key names.  *last keeps the last entry
+   looked up, as the senses of a lemma are together. */
+
+static void count_line(char *line, double *counts, IndexPtr *last)
+{
+    char lemma[WORDBUF], *p;
+    int pos, sstype, fnum, snum, tags;
+    WnId id;
+
+    if ((p = strchr(line, '%')) == NULL || p - line >= WORDBUF ||
+	sscanf(p + 1, "%d:%d%*s %d %d", &sstype, &fnum, &snum, &tags) != 4)
+	return;
+    pos = sstype == SATELLITE ? ADJ : sstype;
+    if (pos < 1 || pos > NUMPARTS)
+	return;
+    memcpy(lemma, line, p - line);
+    lemma[p - line] = '\0';
+
+    if (*last == NULL || (*last)->pos[0] != partchars[pos] ||
+	strcmp((*last)->wd, lemma)) {
+	if (*last)
+	    free_index(*last);
+	*last = index_lookup(lemma, pos);
+    }
+    if (*last && snum >= 1 && snum <= (*last)->off_cnt &&
+	synset_matches(pos, (*last)->offset[snum - 1], fnum, sstype) &&
+	(id = wn_synset_id(pos, (*last)->offset[snum - 1])) != WN_NOID)
+	counts[id] += tags;
+}
+
+/* Add the counts of every sense in cntlist.rev to their synsets, in
+   one pass through the file */
+
+static void count_tags(double *counts)
+{
+    char line[LINEBUF], *base, *p, *nl;
+    IndexPtr last = NULL;
+    long size, len;
+
+    if (cntlistfp == NULL)
+	return;
+    if ((base = wn_mapped(cntlistfp, &size)) != NULL) {
+	for (p = base; p < base + size; p = nl + 1) {
+	    if ((nl = memchr(p, '\n', base + size - p)) == NULL)
+		nl = base + size;
+	    len = nl - p < LINEBUF ? nl - p : LINEBUF - 1;
+	    memcpy(line, p, len);
+	    line[len] = '\0';
+	    count_line(line, counts, &last);
+	}
+    } else {
+	rewind(cntlistfp);
+	while (fgets(line, LINEBUF, cntlistfp) != NULL)
+	    count_line(line, counts, &last);
+    }
+    if (last)
+	free_index(last);
+}
+
+/* Build the information content table from the tag counts in
+   cntlist.rev and write it to file, or the default file if NULL.
+   Returns 0, or -1 if the graph can't be loaded or the file written. */
+
+int wn_ic_build(const char *file)
+{
+    struct icheader h;
+    double *counts, *ic, total[NUMPARTS + 1], freq, *arg[2];
+    char path[ICPATHBUF];
+    long n, id;
+    int err = 0;
+    FILE *fp;
+
+    if (wn_graph_load() != 0 || describe(&h) != 0)
+	return(-1);
+    if (file == NULL) {
+	if (default_file(path) != 0)
+	    return(-1);
+	file = path;
+    }
+    n = h.nsyns;
+    counts = calloc(n, sizeof(double));
+    ic = malloc(n * sizeof(double));
+    WNSTAT(allocs, 2);
+    if (counts == NULL || ic == NULL) {
+	free(counts);
+	free(ic);
+	return(-1);
+    }
+
+    memset(total, 0, sizeof(total));
+    count_tags(counts);
+    for (id = 0; id < n; id++) {
+	counts[id] += 1.0;
+	total[wn_id_pos(id)] += counts[id];
+    }
+    arg[0] = counts;
+    arg[1] = &freq;
+    for (id = 0; id < n; id++) {
+	freq = counts[id];
+	wn_descendants(id, addfreq, arg);
+	ic[id] = -log(freq / total[wn_id_pos(id)]);
+    }
+
+    if ((fp = fopen(file, "wb")) == NULL) {
+	snprintf(msgbuf, sizeof(msgbuf),
+		 "WordNet library error: cannot write %.200s\n", file);
+	display_message(msgbuf);
+	err = -1;
+    } else {
+	if (fwrite(&h, sizeof(h), 1, fp) != 1 ||
+	    fwrite(ic, sizeof(double), n, fp) != (size_t)n)
+	    err = -1;
+	if (fclose(fp) != 0)
+	    err = -1;
+    }
+    free(counts);
+    free(ic);
+    return(err ? -1 : 0);
+}
+
+/* Load the information content table from file, or the default file
+   if NULL.  The pointer graph must be loaded.  Returns 0, or -1 if the
+   file can't be read or was built from a different database. */
+
+int wn_ic_load(const char *file)
+{
+    struct icheader h, *fh;
+    char path[ICPATHBUF], *base;
+    long size;
+    FILE *fp;
+
+    wn_ic_free();
+    if (describe(&h) != 0)
+	return(-1);
+    if (file == NULL) {
+	if (default_file(path) != 0)
+	    return(-1);
+	file = path;
+    }
+    if ((fp = fopen(file, "rb")) == NULL)
+	return(-1);
+
+    if (wn_map_file(fp) == 0 && (base = wn_mapped(fp, &size)) != NULL)
+	icfp = fp;
+    else {
+	wn_unmap_file(fp);	/* mapped but unusable, e.g. legacyflag */
+	fseek(fp, 0L, SEEK_END);
+	size = ftell(fp);
+	rewind(fp);
+	if ((icbuf = malloc(size > 0 ? size : 1)) == NULL ||
+	    fread(icbuf, 1, size, fp) != (size_t)size) {
+	    free(icbuf);
+	    icbuf = NULL;
+	    fclose(fp);
+	    return(-1);
+	}
+	WNSTAT(allocs, 1);
+	fclose(fp);
+	base = icbuf;
+    }
+
+    fh = (struct icheader *)base;
+    if (size < (long)sizeof(h) ||
+	memcmp(fh, &h, sizeof(h)) != 0 ||
+	size != (long)(sizeof(h) + h.nsyns * sizeof(double))) {
+	snprintf(msgbuf, sizeof(msgbuf),
+		 "WordNet library error: %.150s is not an information content file for this database\n",
+		 file);
+	display_message(msgbuf);
+	wn_ic_free();
+	return(-1);
+    }
+    ictable = (double *)(base + sizeof(h));
+    icsyns = h.nsyns;
+    return(0);
+}
+
+void wn_ic_free(void)
+{
+    if (icfp) {
+	wn_unmap_file(icfp);
+	fclose(icfp);
+    }
+    free(icbuf);
+    icfp = NULL;
+    icbuf = NULL;
+    ictable = NULL;
+    icsyns = 0;
+}
+
+/* Return information content of synset id, or -1 if no table is
+   loaded */
+
+double wn_ic(WnId id)
+{
+    if (ictable == NULL || id >= icsyns)
+	return(-1.0);
+    return(ictable[id]);
+}
@@ -0,0 +1,111 @@
+/*
+
+   wnmmap.c - in-memory access to database files
+
+   Database files opened by the library are also mapped into memory
+   where the platform supports it.  bin_search(), read_index() and
+   read_synset() then read lines from the mapping instead of seeking
+   and reading through stdio, giving the same results without a system
+   call per probe.  The FILE pointers stay open, so code that reads the
+   files sequentially is unaffected.  Setting legacyflag (or WNLEGACY in
+   the environment) makes the library use stdio for everything.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#include "wn.h"
+
+#define MAXMAPS		32
+
+static struct {
+    FILE *fp;
+    char *base;
+    long size;
+} maps[MAXMAPS];
+static int nmaps;
+
+/* Map file open on fp.  Returns 0 on success, -1 if the file can't
+   be mapped, in which case it is simply read through stdio. */
+
+int wn_map_file(FILE *fp)
+{
+#ifndef _WIN32
+    struct stat st;
+    void *base;
+
+    if (fp == NULL || nmaps == MAXMAPS ||
+	fstat(fileno(fp), &st) != 0 || st.st_size == 0)
+	return(-1);
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if (base == MAP_FAILED)
+	return(-1);
+    maps[nmaps].fp = fp;
+    maps[nmaps].base = base;
+    maps[nmaps].size = (long)st.st_size;
+    nmaps++;
+    return(0);
+#else
+    return(-1);
+#endif
+}
+
+/* Remove mapping of fp, if any.  Call before closing the file. */
+
+void wn_unmap_file(FILE *fp)
+{
+    int i;
+
+    for (i = 0; i < nmaps; i++)
+	if (maps[i].fp == fp) {
+#ifndef _WIN32
+	    munmap(maps[i].base, maps[i].size);
+#endif
+	    maps[i] = maps[--nmaps];
+	    return;
+	}
+}
+
+/* Return start of the mapping of fp and store its size, or NULL if the
+   file isn't mapped or legacyflag is set. */
+
+char *wn_mapped(FILE *fp, long *size)
+{
+    int i;
+
+    if (legacyflag)
+	return(NULL);
+    for (i = 0; i < nmaps; i++)
+	if (maps[i].fp == fp) {
+	    *size = maps[i].size;
+	    return(maps[i].base);
+	}
+    return(NULL);
+}
+
+/* Copy the line starting at offset into buf as fgets() would.
+   Returns 1 if a line was copied, 0 at end of file, or -1 if fp
+   isn't mapped. */
+
+int wn_map_line(FILE *fp, long offset, char *buf, int bufsize)
+{
+    char *base, *nl;
+    long size, len;
+
+    if ((base = wn_mapped(fp, &size)) == NULL)
+	return(-1);
+    if (offset < 0 || offset >= size)
+	return(0);
+    len = size - offset < bufsize - 1 ? size - offset : bufsize - 1;
+    if ((nl = memchr(base + offset, '\n', len)) != NULL)
+	len = nl - (base + offset) + 1;
+    memcpy(buf, base + offset, len);
+    buf[len] = '\0';
+    WNSTAT(bytesread, len);
+    return(1);
+}
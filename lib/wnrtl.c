@@ -21,6 +21,7 @@ int frflag = 0;			/* if set, print verb frames */
 int abortsearch = 0;		/* if set, stop search algorithm */
 int offsetflag = 0;		/* if set, print byte offset of each synset */
 int wnsnsflag = 0;		/* if set, print WN sense # for each word */
+int legacyflag = 0;		/* if set, use only the stdio search code */
 
 /* File pointers for database files */
 
@@ -0,0 +1,378 @@
+/*
+
+   wnsim.c - semantic similarity of synsets
+
+   Path, Wu-Palmer and Leacock-Chodorow similarity are computed from
+   the hypernyms (and instance hypernyms) above two synsets, found in
+   the in-memory pointer graph, and the depths from the is-a labelling
+   in wngraph.c.  Resnik, Lin and Jiang-Conrath similarity also need
+   the information content table loaded by wn_ic_load().  Nothing here
+   keeps static state, so once the graph and labelling are built these
+   functions can be called from several threads at once.
+   wn_similarity_matrix() does so itself when the library is built
+   with WN_THREADS, giving each thread a band of rows.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef WN_THREADS
+#include <pthread.h>
+#endif
+#include "wn.h"
+
+#define MAXTHREADS	64
+#define EDGEBUF		64
+
+/* Synset above another, and the fewest pointers up to it */
+struct ancestor {
+    WnId id;
+    int dist;
+};
+
+/* Common subsumer of a pair, and the fewest pointers down to each,
+   and the greatest information content of any common subsumer */
+struct subsumer {
+    WnId id;
+    int depth;
+    int dista, distb;
+    double ic;
+};
+
+/* Store synset id and all synsets above it in *list, nearest first.
+   Returns the number stored, or -1 if out of memory. */
+
+static int ancestors(WnId id, struct ancestor **list, int *size)
+{
+    WnEdge buf[EDGEBUF], *edges;
+    struct ancestor *p;
+    int n = 0, i, j, k, cnt;
+
+    if (*size < 16) {
+	if ((p = realloc(*list, 16 * sizeof(struct ancestor))) == NULL)
+	    return(-1);
+	*list = p;
+	*size = 16;
+    }
+    (*list)[n].id = id;
+    (*list)[n++].dist = 0;
+
+    /* The list is its own breadth first queue */
+    for (i = 0; i < n; i++) {
+	edges = buf;
+	cnt = wn_id_ptrs((*list)[i].id, 0, edges, EDGEBUF);
+	if (cnt > EDGEBUF) {
+	    if ((edges = malloc(cnt * sizeof(WnEdge))) == NULL)
+		return(-1);
+	    cnt = wn_id_ptrs((*list)[i].id, 0, edges, cnt);
+	}
+	for (j = 0; j < cnt; j++) {
+	    if ((edges[j].ptrtyp != HYPERPTR && edges[j].ptrtyp != INSTANCE) ||
+		edges[j].id == WN_NOID)
+		continue;
+	    for (k = 0; k < n && (*list)[k].id != edges[j].id; k++)
+		;
+	    if (k < n)
+		continue;
+	    if (n == *size) {
+		if ((p = realloc(*list, *size * 2 * sizeof(struct ancestor)))
+		    == NULL) {
+		    if (edges != buf)
+			free(edges);
+		    return(-1);
+		}
+		*list = p;
+		*size *= 2;
+	    }
+	    (*list)[n].id = edges[j].id;
+	    (*list)[n++].dist = (*list)[i].dist + 1;
+	}
+	if (edges != buf)
+	    free(edges);
+    }
+    return(n);
+}
+
+/* Consider common subsumer c of a pair as the lowest: the deepest one
+   is, then the nearest, then the one with the smallest id. */
+
+static void consider(struct subsumer *lcs, int *shortest,
+		     WnId c, int dista, int distb)
+{
+    int depth = wn_depth(c);
+    double ic = wn_ic(c);
+
+    if (ic > lcs->ic)
+	lcs->ic = ic;
+    if (dista + distb < *shortest)
+	*shortest = dista + distb;
+    if (lcs->id == WN_NOID || depth > lcs->depth ||
+	(depth == lcs->depth &&
+	 (dista + distb < lcs->dista + lcs->distb ||
+	  (dista + distb == lcs->dista + lcs->distb && c < lcs->id)))) {
+	lcs->id = c;
+	lcs->depth = depth;
+	lcs->dista = dista;
+	lcs->distb = distb;
+    }
+}
+
+/* Work out the similarity of a and b from their lowest common subsumer
+   and the shortest path between them through any common subsumer.
+   Where they have none, nouns and verbs are given one above all the
+   tops of the hierarchy, whose information content is 0. */
+
+static double score(WnId a, WnId b, int pos, int measure,
+		    struct subsumer *lcs, int shortest)
+{
+    int depth, maxdepth;
+    double ica, icb, dist;
+
+    maxdepth = wn_max_depth(pos) + 1;
+    if (lcs->id == WN_NOID) {
+	if (pos != NOUN && pos != VERB)
+	    return(-1.0);
+	lcs->dista = wn_depth(a) + 1;
+	lcs->distb = wn_depth(b) + 1;
+	shortest = lcs->dista + lcs->distb;
+	depth = 0;
+    } else
+	depth = lcs->depth + 1;
+    if (pos == NOUN || pos == VERB)
+	maxdepth++;
+
+    switch (measure) {
+    case WN_SIM_PATH:
+	return(1.0 / (shortest + 1));
+    case WN_SIM_WUP:
+	return(2.0 * depth / (lcs->dista + lcs->distb + 2.0 * depth));
+    case WN_SIM_LCH:
+	return(-log((shortest + 1) / (2.0 * maxdepth)));
+    case WN_SIM_RES:
+    case WN_SIM_LIN:
+    case WN_SIM_JCN:
+	if ((ica = wn_ic(a)) < 0 || (icb = wn_ic(b)) < 0)
+	    return(-1.0);
+	if (measure == WN_SIM_RES)
+	    return(lcs->ic);
+	if (measure == WN_SIM_LIN)
+	    return(ica + icb > 0 ? 2.0 * lcs->ic / (ica + icb) : 1.0);
+	dist = ica + icb - 2.0 * lcs->ic;
+	return(dist > 0 ? 1.0 / dist : 1e300);
+    }
+    return(-1.0);
+}
+
+/* Return the lowest common subsumer of synsets a and b through
+   hypernym and instance pointers (which may be a or b), or WN_NOID */
+
+WnId wn_lcs(WnId a, WnId b)
+{
+    struct ancestor *la = NULL, *lb = NULL;
+    struct subsumer lcs;
+    int sizea = 0, sizeb = 0, na, nb, i, j, shortest = 0x7fffffff;
+
+    lcs.id = WN_NOID;
+    lcs.ic = 0.0;
+    if (wn_max_depth(NOUN) < 0 || wn_id_pos(a) == 0 || wn_id_pos(b) == 0)
+	return(WN_NOID);
+    if ((na = ancestors(a, &la, &sizea)) > 0 &&
+	(nb = ancestors(b, &lb, &sizeb)) > 0)
+	for (j = 0; j < nb; j++)
+	    for (i = 0; i < na; i++)
+		if (la[i].id == lb[j].id)
+		    consider(&lcs, &shortest, lb[j].id, la[i].dist, lb[j].dist);
+    free(la);
+    free(lb);
+    return(lcs.id);
+}
+
+/* Return the similarity of synsets a and b by measure, or -1 if they
+   are of different parts of speech or it isn't defined for them */
+
+double wn_similarity(WnId a, WnId b, int measure)
+{
+    struct ancestor *la = NULL, *lb = NULL;
+    struct subsumer lcs;
+    int sizea = 0, sizeb = 0, na, nb = 0, i, j, pos;
+    int shortest = 0x7fffffff;
+    double sim = -1.0;
+
+    lcs.id = WN_NOID;
+    lcs.ic = 0.0;
+    if (wn_max_depth(NOUN) < 0 || (pos = wn_id_pos(a)) == 0 ||
+	wn_id_pos(b) != pos)
+	return(-1.0);
+    if ((na = ancestors(a, &la, &sizea)) > 0 &&
+	(nb = ancestors(b, &lb, &sizeb)) > 0) {
+	for (j = 0; j < nb; j++)
+	    for (i = 0; i < na; i++)
+		if (la[i].id == lb[j].id)
+		    consider(&lcs, &shortest, lb[j].id, la[i].dist, lb[j].dist);
+	sim = score(a, b, pos, measure, &lcs, shortest);
+    }
+    free(la);
+    free(lb);
+    return(sim);
+}
+
+/* Shared by the threads computing a matrix */
+struct matrix {
+    WnId *rows, *cols;
+    int nrows, ncols, measure;
+    struct ancestor **colanc;	/* ancestors of each column synset */
+    int *ncolanc;
+    double *out;
+    int failed;			/* column set up or any band failed */
+};
+
+/* Band of rows one thread computes */
+struct band {
+    struct matrix *m;
+    int first, last;
+    int failed;			/* set by this band only */
+};
+
+/* Compute rows first to last - 1.  The ancestors of each row synset
+   are marked in arrays indexed by synset id, so each pair takes one
+   look up per ancestor of the column synset. */
+
+static void *matrix_band(void *arg)
+{
+    struct band *band = arg;
+    struct matrix *m = band->m;
+    struct ancestor *la = NULL, *lb;
+    struct subsumer lcs;
+    unsigned int *mark;
+    int *dist, size = 0, na, nb, r, c, j, pos, shortest;
+    long nsyns = wn_synset_count();
+    WnId a, x;
+
+    mark = calloc(nsyns, sizeof(unsigned int));
+    dist = malloc(nsyns * sizeof(int));
+    if (mark == NULL || dist == NULL) {
+	free(mark);
+	free(dist);
+	band->failed = 1;
+	return(NULL);
+    }
+
+    for (r = band->first; r < band->last; r++) {
+	a = m->rows[r];
+	pos = wn_id_pos(a);
+	na = pos ? ancestors(a, &la, &size) : 0;
+	if (na < 0) {
+	    band->failed = 1;
+	    break;
+	}
+	for (j = 0; j < na; j++) {
+	    mark[la[j].id] = (unsigned int)(r + 1);
+	    dist[la[j].id] = la[j].dist;
+	}
+	for (c = 0; c < m->ncols; c++) {
+	    if (na == 0 || wn_id_pos(m->cols[c]) != pos) {
+		m->out[(long)r * m->ncols + c] = -1.0;
+		continue;
+	    }
+	    lcs.id = WN_NOID;
+	    lcs.ic = 0.0;
+	    shortest = 0x7fffffff;
+	    lb = m->colanc[c];
+	    nb = m->ncolanc[c];
+	    for (j = 0; j < nb; j++)
+		if (mark[x = lb[j].id] == (unsigned int)(r + 1))
+		    consider(&lcs, &shortest, x, dist[x], lb[j].dist);
+	    m->out[(long)r * m->ncols + c] =
+		score(a, m->cols[c], pos, m->measure, &lcs, shortest);
+	}
+    }
+    free(la);
+    free(mark);
+    free(dist);
+    return(NULL);
+}
+
+/* Store the similarity by measure of each of nrows synsets in rows to
+   each of ncols synsets in cols in out, row by row, using up to
+   nthreads threads.  Returns 0, or -1 if the graph isn't loaded or
+   memory runs out. */
+
+int wn_similarity_matrix(WnId *rows, int nrows, WnId *cols, int ncols,
+			 int measure, double *out, int nthreads)
+{
+    struct matrix m;
+    struct band bands[MAXTHREADS];
+    int i, size;
+#ifdef WN_THREADS
+    pthread_t threads[MAXTHREADS];
+    int started[MAXTHREADS];
+#endif
+
+    /* Builds the labelling before any threads use it */
+    if (wn_max_depth(NOUN) < 0)
+	return(-1);
+
+    m.rows = rows;
+    m.cols = cols;
+    m.nrows = nrows;
+    m.ncols = ncols;
+    m.measure = measure;
+    m.out = out;
+    m.failed = 0;
+    m.colanc = calloc(ncols + 1, sizeof(struct ancestor *));
+    m.ncolanc = calloc(ncols + 1, sizeof(int));
+    if (m.colanc == NULL || m.ncolanc == NULL) {
+	free(m.colanc);
+	free(m.ncolanc);
+	return(-1);
+    }
+    for (i = 0; i < ncols && !m.failed; i++) {
+	size = 0;
+	if (wn_id_pos(cols[i]) &&
+	    (m.ncolanc[i] = ancestors(cols[i], &m.colanc[i], &size)) < 0)
+	    m.failed = 1;
+    }
+
+#ifndef WN_THREADS
+    nthreads = 1;
+#endif
+    if (nthreads > MAXTHREADS)
+	nthreads = MAXTHREADS;
+    if (nthreads > nrows)
+	nthreads = nrows;
+    if (nthreads < 1)
+	nthreads = 1;
+    for (i = 0; i < nthreads; i++) {
+	bands[i].m = &m;
+	bands[i].first = (long)nrows * i / nthreads;
+	bands[i].last = (long)nrows * (i + 1) / nthreads;
+	bands[i].failed = 0;
+    }
+
+    if (!m.failed) {
+#ifdef WN_THREADS
+	for (i = 1; i < nthreads; i++)
+	    started[i] = pthread_create(&threads[i], NULL, matrix_band,
+					&bands[i]) == 0;
+	matrix_band(&bands[0]);
+	for (i = 1; i < nthreads; i++)
+	    if (started[i])
+		pthread_join(threads[i], NULL);
+	    else
+		matrix_band(&bands[i]);
+#else
+	matrix_band(&bands[0]);
+#endif
+	/* Each band flags its own failure; collect them once joined */
+	for (i = 0; i < nthreads; i++)
+	    m.failed |= bands[i].failed;
+    }
+
+    for (i = 0; i < ncols; i++)
+	free(m.colanc[i]);
+    free(m.colanc);
+    free(m.ncolanc);
+    return(m.failed ? -1 : 0);
+}
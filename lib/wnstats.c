@@ -0,0 +1,36 @@
+/*
+
+   wnstats.c - library counters for profiling searches
+
+   The counters themselves are updated in place by the WNSTAT() macro
+   in wn.h, so they cost nothing when the library is built without
+   WN_STATS.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "wn.h"
+
+#ifdef WN_STATS
+WNStats wnstats[2];		/* running totals and current query */
+#endif
+
+/* Return counters selected by which, or NULL if not compiled in. */
+
+WNStats *wn_stats(int which)
+{
+#ifdef WN_STATS
+    if (which == WNSTATS_TOTAL || which == WNSTATS_QUERY)
+	return(&wnstats[which]);
+#endif
+    return(NULL);
+}
+
+void wn_stats_reset(int which)
+{
+#ifdef WN_STATS
+    if (which == WNSTATS_TOTAL || which == WNSTATS_QUERY)
+	memset(&wnstats[which], 0, sizeof(WNStats));
+#endif
+}
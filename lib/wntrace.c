@@ -0,0 +1,185 @@
+/*
+
+   wntrace.c - trace spans of library searches
+
+   Spans are recorded by the WNTRACE_BEGIN() and WNTRACE_END() macros
+   in wn.h into a ring buffer owned by the calling thread, so recording
+   takes no locks.  Each ring is added once to a global list with a
+   compare-and-swap.  wn_trace_stop() writes every ring out as Chrome
+   trace event JSON, which can be loaded into chrome://tracing or
+   Perfetto.  When a ring fills, the oldest spans are overwritten.
+
+   Setting WNTRACE to a file name before wninit() traces the whole run
+   and writes the file when the program exits.
+
+*/
+
+#ifdef _WINDOWS
+#include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WINDOWS
+#include <time.h>
+#endif
+#include "wn.h"
+
+#ifdef WN_TRACE
+
+#define TRACERING	(64*1024)	/* spans kept per thread */
+
+#if defined(_MSC_VER)
+#define THREADLOCAL	__declspec(thread)
+#define CAS(ptr, old, new) \
+    (InterlockedCompareExchangePointer((PVOID *)(ptr), (new), (old)) == (old))
+#define FETCHADD(ptr, n)	InterlockedExchangeAdd((ptr), (n))
+#else
+#define THREADLOCAL	__thread
+#define CAS(ptr, old, new)	__sync_bool_compare_and_swap((ptr), (old), (new))
+#define FETCHADD(ptr, n)	__sync_fetch_and_add((ptr), (n))
+#endif
+
+struct tracespan {
+    const char *name;		/* static string naming the span */
+    double start;		/* microseconds since trace start */
+    double dur;			/* microseconds */
+};
+
+struct tracering {
+    struct tracespan spans[TRACERING];
+    unsigned long count;	/* spans ever recorded */
+    long tid;
+    struct tracering *next;
+};
+
+int wntracing = 0;
+
+static THREADLOCAL struct tracering *myring;
+static struct tracering *rings;	/* all rings, newest first */
+static long nextid = 1;
+static double tracebase;
+static char *tracefile;
+
+double wn_trace_now(void)
+{
+#ifdef _WINDOWS
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (freq.QuadPart == 0)
+	QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return((double)now.QuadPart * 1e6 / (double)freq.QuadPart - tracebase);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3 - tracebase);
+#endif
+}
+
+/* Record span name that began at start and ends now */
+
+void wn_trace_span(const char *name, double start)
+{
+    struct tracering *ring = myring;
+    struct tracespan *sp;
+
+    if (ring == NULL) {
+	if ((ring = calloc(1, sizeof(struct tracering))) == NULL)
+	    return;
+	ring->tid = FETCHADD(&nextid, 1);
+	do
+	    ring->next = rings;
+	while (!CAS(&rings, ring->next, ring));
+	myring = ring;
+    }
+    sp = &ring->spans[ring->count % TRACERING];
+    sp->name = name;
+    sp->start = start;
+    sp->dur = wn_trace_now() - start;
+    ring->count++;
+}
+
+static void trace_atexit(void)
+{
+    wn_trace_stop();
+}
+
+/* Start tracing if WNTRACE names a file.  Called by wninit(). */
+
+void wn_trace_env(void)
+{
+    char *env;
+
+    if ((env = getenv("WNTRACE")) != NULL && *env != '\0' &&
+	wn_trace_start(env) == 0)
+	atexit(trace_atexit);
+}
+
+int wn_trace_start(const char *file)
+{
+    free(tracefile);
+    if ((tracefile = strdup(file)) == NULL)
+	return(-1);
+    if (!wntracing) {
+	tracebase = 0.0;
+	tracebase = wn_trace_now();
+    }
+    wntracing = 1;
+    return(0);
+}
+
+int wn_trace_stop(void)
+{
+    struct tracering *ring;
+    struct tracespan *sp;
+    unsigned long i, first;
+    FILE *fp;
+    int comma = 0;
+    char msgbuf[256];
+
+    if (!wntracing || tracefile == NULL)
+	return(-1);
+    wntracing = 0;
+
+    if ((fp = fopen(tracefile, "w")) == NULL) {
+	snprintf(msgbuf, sizeof(msgbuf),
+		 "WordNet library error: cannot write trace file %s\n",
+		 tracefile);
+	display_message(msgbuf);
+	return(-1);
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for (ring = rings; ring; ring = ring->next) {
+	first = ring->count > TRACERING ? ring->count - TRACERING : 0;
+	for (i = first; i < ring->count; i++) {
+	    sp = &ring->spans[i % TRACERING];
+	    fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"wn\",\"ph\":\"X\","
+		    "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%ld}",
+		    comma ? ",\n" : "", sp->name, sp->start, sp->dur,
+		    ring->tid);
+	    comma = 1;
+	}
+	ring->count = 0;
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    return(fclose(fp) ? -1 : 0);
+}
+
+#else
+
+int wn_trace_start(const char *file)
+{
+    return(-1);
+}
+
+int wn_trace_stop(void)
+{
+    return(-1);
+}
+
+#endif /* WN_TRACE */
@@ -83,6 +83,10 @@ int wninit(void)
 	    OpenDB = 1;
 	    openerr = morphinit();
 	}
+#ifdef WN_TRACE
+	if (!openerr)
+	    wn_trace_env();
+#endif
     }
 
     return(openerr);
@@ -94,6 +98,7 @@ int re_wninit(void)
     char *env;
 
     closefps();
+    wn_flush_caches();
 
     if ((env = getenv("WNDBVERSION")) != NULL) {
 	wnrelease = strdup(env);	/* set release */
@@ -115,27 +120,34 @@ static void closefps(void)
     if (OpenDB) {
 	for (i = 1; i < NUMPARTS + 1; i++) {
 	    if (datafps[i] != NULL) {
+		wn_unmap_file(datafps[i]);
 		fclose(datafps[i]);
 	    }
 	    datafps[i] = NULL;
 	    if (indexfps[i] != NULL) {
+		wn_unmap_file(indexfps[i]);
 		fclose(indexfps[i]);
 	    }
 	    indexfps[i] = NULL;
 	}
 	if (sensefp != NULL) {
+	    wn_unmap_file(sensefp);
 	    fclose(sensefp); sensefp = NULL;
 	}
 	if (cntlistfp != NULL) {
+	    wn_unmap_file(cntlistfp);
 	    fclose(cntlistfp); cntlistfp = NULL;
 	}
 	if (keyindexfp != NULL) {
+	    wn_unmap_file(keyindexfp);
 	    fclose(keyindexfp); keyindexfp = NULL;
 	}
 	if (vsentfilefp != NULL) {
+	    wn_unmap_file(vsentfilefp);
 	    fclose(vsentfilefp); vsentfilefp = NULL;
 	}
 	if (vidxfilefp != NULL) {
+	    wn_unmap_file(vidxfilefp);
 	    fclose(vidxfilefp); vidxfilefp = NULL;
 	}
 	OpenDB = 0;
@@ -251,6 +263,21 @@ static int do_init(void)
 	display_message(msgbuf);
     }
 
+    /* Searches read the files from memory where possible, unless
+       WNLEGACY is set. */
+
+    if (getenv("WNLEGACY") != NULL)
+	legacyflag = 1;
+    for (i = 1; i < NUMPARTS + 1; i++) {
+	wn_map_file(datafps[i]);
+	wn_map_file(indexfps[i]);
+    }
+    wn_map_file(sensefp);
+    wn_map_file(cntlistfp);
+    wn_map_file(keyindexfp);
+    wn_map_file(vsentfilefp);
+    wn_map_file(vidxfilefp);
+
     return(openerr);
 }
 
@@ -535,28 +562,24 @@ char *FmtSynset(SynsetPtr synptr, int defn)
     return(synset);
 }
 
-/* Convert WordNet sense number passed of IndexPtr entry to sense key. */
-char *WNSnsToStr(IndexPtr idx, int sense)
+/* Return sense key of the word of IndexPtr entry in synset sptr, or
+   NULL if it isn't one of the synset's words */
+
+static char *synset_sense_key(IndexPtr idx, SynsetPtr sptr)
 {
-    SynsetPtr sptr, adjss;
-    char sensekey[512], lowerword[256];
-    int j, sstype, pos;
+    SynsetPtr adjss;
+    char sensekey[512], lowerword[256], headword[256];
+    int j, sstype, pos, headsense = 0;
 
     pos = getpos(idx->pos);
-    sptr = read_synset(pos, idx->offset[sense - 1], "");
-
+    headword[0] = '\0';
     if ((sstype = getsstype(sptr->pos)) == SATELLITE) {
 	for (j = 0; j < sptr->ptrcount; j++) {
 	    if (sptr->ptrtyp[j] == SIMPTR) {
 		adjss = read_synset(sptr->ppos[j],sptr->ptroff[j],"");
-		sptr->headword = malloc (strlen(adjss->words[0]) + 1);
-		assert(sptr->headword);
-		snprintf(sptr->headword,
-			 strlen(adjss->words[0]) + 1,
-			 "%s",
-			 adjss->words[0]);
-		strtolower(sptr->headword);
-		sptr->headsense = adjss->lexid[0];
+		snprintf(headword, sizeof(headword), "%s", adjss->words[0]);
+		strtolower(headword);
+		headsense = adjss->lexid[0];
 		free_synset(adjss); 
 		break;
 	    }
@@ -570,23 +593,32 @@ char *WNSnsToStr(IndexPtr idx, int sense)
 	    break;
     }
 
-    if (j == sptr->wcount) {
-	free_synset(sptr);
+    if (j == sptr->wcount)
 	return(NULL);
-    }
 
     if (sstype == SATELLITE) 
 	sprintf(sensekey,"%s%%%-1.1d:%-2.2d:%-2.2d:%s:%-2.2d",
 		idx->wd, SATELLITE, sptr->fnum,
-		sptr->lexid[j], sptr->headword,sptr->headsense);
+		sptr->lexid[j], headword, headsense);
     else 
 	sprintf(sensekey,"%s%%%-1.1d:%-2.2d:%-2.2d::",
 		idx->wd, pos, sptr->fnum, sptr->lexid[j]);
 
-    free_synset(sptr);
     return(strdup(sensekey));
 }
-
+
+/* Convert WordNet sense number passed of IndexPtr entry to sense key. */
+char *WNSnsToStr(IndexPtr idx, int sense)
+{
+    SynsetPtr sptr;
+    char *sensekey;
+
+    sptr = read_synset(getpos(idx->pos), idx->offset[sense - 1], "");
+    sensekey = synset_sense_key(idx, sptr);
+    free_synset(sptr);
+    return(sensekey);
+}
+
 /* Search for string and/or baseform of word in database and return
    index structure for word if found in database. */
 
@@ -639,6 +671,7 @@ SnsIndexPtr GetSenseIndex(char *sensekey)
 	       &snsidx->tag_cnt);
 	snsidx->sensekey = malloc(strlen(buf) + 1);
 	assert(snsidx->sensekey);
+	WNSTAT(allocs, 3);
 	snprintf(snsidx->sensekey, strlen(buf) + 1, "%s", buf);
 	snsidx->loc = atol(loc);
 	/* Parse out word from sensekey to make things easier for caller */
@@ -669,6 +702,25 @@ int GetTagcnt(IndexPtr idx, int sense)
     return(cnt);
 }
 
+/* As GetTagcnt(), for the sense of IndexPtr entry in synset sptr
+   already read, rather than reading it again */
+
+int GetSynsetTagcnt(IndexPtr idx, SynsetPtr sptr)
+{
+    char *sensekey, *line;
+    char buf[256];
+    int snum, cnt = 0;
+
+    if (cntlistfp && (sensekey = synset_sense_key(idx, sptr)) != NULL) {
+	if ((line = bin_search(sensekey, cntlistfp)) != NULL) {
+	    sscanf(line, "%255s %d %d", buf, &snum, &cnt);
+	}
+	free(sensekey);
+    }
+
+    return(cnt);
+}
+
 void FreeSenseIndex(SnsIndexPtr snsidx)
 {
     if (snsidx) {
@@ -0,0 +1,704 @@
+/*
+
+  wn-bench.c - Benchmark suite for the WordNet library
+
+  Micro benchmarks time the individual lookup primitives (bin_search,
+  index_lookup, getindex, read_synset, morphstr, is_defined).  Macro
+  benchmarks time findtheinfo() for every search offered by wn.  Both
+  run over a corpus sampled evenly from the index files.
+
+  For each benchmark the mean and percentile latencies are reported in
+  nanoseconds per operation, together with the number of library
+  allocations (if it counts them) and read/write system calls per
+  operation (where the platform lets us count them).  Results can also be written as JSON with -o so they can
+  be compared across releases.
+
+  With -gate, every search is instead run over every lemma (or the
+  -n sample) twice: once with legacyflag set, so the library uses
+  only its original stdio code, and once with its in-memory and cached
+  paths.  The output of the two must be identical, and the accelerated
+  path must be at least -ratio times as fast, or wn-bench exits with
+  status 1.  Output that differs only because the legacy code reported
+  a pointer cycle, which it follows to MAXDEPTH, is counted separately.
+
+  Both paths share the search code, so a change to it that alters
+  output on both goes unnoticed.  With -ref wn, the gate also runs the
+  given wn program, built from an earlier release, and the wn beside
+  wn-bench (or the one given with -wn) on each word for each search,
+  and fails unless their output and exit status are the same, for
+  words whose searches don't reach a pointer cycle.
+
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#include "wn.h"
+#include "wnopts.h"
+
+#define DEFAULTSAMPLES	100	/* words sampled from each index file */
+#define DEFAULTREPS	3	/* passes over the corpus per benchmark */
+#define DEFAULTRATIO	1.0	/* minimum speedup required by -gate */
+#define MAXDIFFS	10	/* differences reported by -gate */
+
+/* The macro benchmarks run each search of wn's option list, skipping
+   old names for searches that are run under another option */
+
+#define searched(i)	(!(optlist[i].flags & OPTALIAS))
+
+/* Sampled corpus: lemma and offset of its first sense */
+
+struct sample {
+    char word[WORDBUF];
+    long offset;
+};
+
+static struct sample *corpus[NUMPARTS + 1];
+static int ncorpus[NUMPARTS + 1];
+
+/* Timing */
+
+static double nanotime(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (freq.QuadPart == 0)
+	QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((double)ts.tv_sec * 1e9 + (double)ts.tv_nsec);
+#endif
+}
+
+/* Allocation counting.  The library counts its own allocations when
+   it is built with WN_STATS; otherwise they are not counted. */
+
+static long nallocs(void)
+{
+    WNStats *st;
+
+    return((st = wn_stats(WNSTATS_TOTAL)) != NULL ? (long)st->allocs : -1);
+}
+
+/* System call counting.  Linux reports the number of read and write
+   system calls made by the process in /proc/self/io. */
+
+static long syscall_overhead;
+
+static long syscalls(void)
+{
+#ifdef __linux__
+    char buf[512], *p;
+    long total = 0;
+    int fd, n;
+
+    if ((fd = open("/proc/self/io", O_RDONLY)) < 0)
+	return(-1);
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+	return(-1);
+    buf[n] = '\0';
+    if ((p = strstr(buf, "syscr:")) != NULL)
+	total += atol(p + 6);
+    if ((p = strstr(buf, "syscw:")) != NULL)
+	total += atol(p + 6);
+    return(total);
+#else
+    return(-1);
+#endif
+}
+
+/* Results */
+
+struct result {
+    char name[32];
+    int pos;
+    long ops;
+    double mean, p50, p90, p99, max;
+    double allocs;		/* per op, or -1 if not counted */
+    double syscalls;		/* per op, or -1 if not counted */
+};
+
+static struct result *results;
+static int nresults, maxresults;
+static double *times;
+static long maxtimes;
+
+static int cmpdouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return(x < y ? -1 : x > y);
+}
+
+static double percentile(double *sorted, long n, double pct)
+{
+    long i = (long)(pct / 100.0 * (n - 1) + 0.5);
+
+    return(n ? sorted[i] : 0.0);
+}
+
+/* Benchmark bodies.  Each performs one operation on one sample. */
+
+typedef void (*benchfn)(struct sample *, int, int);
+
+static void b_bin_search(struct sample *s, int pos, int arg)
+{
+    (void)arg;
+    bin_search(s->word, indexfps[pos]);
+}
+
+static void b_index_lookup(struct sample *s, int pos, int arg)
+{
+    IndexPtr idx;
+
+    (void)arg;
+    if ((idx = index_lookup(s->word, pos)) != NULL)
+	free_index(idx);
+}
+
+static void b_getindex(struct sample *s, int pos, int arg)
+{
+    IndexPtr idx;
+
+    (void)arg;
+    for (idx = getindex(s->word, pos); idx; idx = getindex(NULL, pos))
+	free_index(idx);
+}
+
+static void b_read_synset(struct sample *s, int pos, int arg)
+{
+    SynsetPtr syn;
+
+    (void)arg;
+    if ((syn = read_synset(pos, s->offset, "")) != NULL)
+	free_synset(syn);
+}
+
+static void b_morphstr(struct sample *s, int pos, int arg)
+{
+    char *morph;
+
+    (void)arg;
+    for (morph = morphstr(s->word, pos); morph; morph = morphstr(NULL, pos))
+	;
+}
+
+static void b_is_defined(struct sample *s, int pos, int arg)
+{
+    (void)arg;
+    is_defined(s->word, pos);
+}
+
+static void b_findtheinfo(struct sample *s, int pos, int search)
+{
+    char word[WORDBUF];
+
+    strcpy(word, s->word);
+    findtheinfo(word, pos, search, ALLSENSES);
+}
+
+static void run(char *name, int pos, benchfn fn, int arg, int reps)
+{
+    struct result *r;
+    long i, n = 0, allocs, sys;
+    double start;
+    int rep;
+
+    if (ncorpus[pos] == 0)
+	return;
+
+    if (nresults == maxresults) {
+	maxresults = maxresults ? maxresults * 2 : 64;
+	results = realloc(results, maxresults * sizeof(*results));
+    }
+    r = &results[nresults++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->pos = pos;
+
+    fn(&corpus[pos][0], pos, arg);	/* warm up */
+
+    sys = syscalls();
+    allocs = nallocs();
+    for (rep = 0; rep < reps; rep++)
+	for (i = 0; i < ncorpus[pos]; i++) {
+	    start = nanotime();
+	    fn(&corpus[pos][i], pos, arg);
+	    times[n++] = nanotime() - start;
+	}
+    allocs = allocs < 0 ? -1 : nallocs() - allocs;
+    sys = sys < 0 ? -1 : syscalls() - sys - syscall_overhead;
+
+    r->ops = n;
+    for (i = 0; i < n; i++)
+	r->mean += times[i];
+    r->mean /= n;
+    qsort(times, n, sizeof(*times), cmpdouble);
+    r->p50 = percentile(times, n, 50);
+    r->p90 = percentile(times, n, 90);
+    r->p99 = percentile(times, n, 99);
+    r->max = times[n - 1];
+    r->allocs = allocs < 0 ? -1 : (double)allocs / n;
+    r->syscalls = sys < 0 ? -1 : (double)sys / n;
+
+    printf("%-14s %-5s %8ld %12.0f %12.0f %12.0f %12.0f %10.2f %10.2f\n",
+	   r->name, partnames[pos], r->ops, r->mean, r->p50, r->p99, r->max,
+	   r->allocs, r->syscalls);
+    fflush(stdout);
+}
+
+/* Sample up to n lemmas spread evenly through each index file, or
+   every lemma if n is 0 */
+
+static void load_corpus(int n)
+{
+    char line[LINEBUF], *wd;
+    long count, i, step, want;
+    IndexPtr idx;
+    int pos;
+
+    for (pos = 1; pos <= NUMPARTS; pos++) {
+	ncorpus[pos] = 0;
+	if (indexfps[pos] == NULL)
+	    continue;
+
+	rewind(indexfps[pos]);
+	for (count = 0; fgets(line, sizeof(line), indexfps[pos]); )
+	    if (line[0] != ' ')
+		count++;
+	want = (n > 0 && n < count) ? n : count;
+	step = count > want ? count / want : 1;
+	corpus[pos] = malloc((want + 1) * sizeof(struct sample));
+
+	rewind(indexfps[pos]);
+	for (i = 0; ncorpus[pos] < want && fgets(line, sizeof(line), indexfps[pos]); ) {
+	    if (line[0] == ' ' || i++ % step)
+		continue;
+	    wd = strtok(line, " ");
+	    if ((idx = index_lookup(wd, pos)) == NULL)
+		continue;
+	    strcpy(corpus[pos][ncorpus[pos]].word, idx->wd);
+	    corpus[pos][ncorpus[pos]].offset = idx->offset[0];
+	    ncorpus[pos]++;
+	    free_index(idx);
+	}
+    }
+}
+
+static void write_json(char *file, int samples, int reps)
+{
+    FILE *fp;
+    struct result *r;
+    int i;
+
+    if ((fp = fopen(file, "w")) == NULL) {
+	fprintf(stderr, "wn-bench: cannot open %s\n", file);
+	exit(-1);
+    }
+    fprintf(fp, "{\n  \"release\": \"%s\",\n  \"samples\": %d,\n  \"reps\": %d,\n  \"results\": [\n",
+	    wnrelease, samples, reps);
+    for (i = 0; i < nresults; i++) {
+	r = &results[i];
+	fprintf(fp, "    {\"bench\": \"%s\", \"pos\": \"%s\", \"ops\": %ld, "
+		"\"ns_mean\": %.1f, \"ns_p50\": %.1f, \"ns_p90\": %.1f, "
+		"\"ns_p99\": %.1f, \"ns_max\": %.1f, "
+		"\"allocs_per_op\": %.3f, \"syscalls_per_op\": %.3f}%s\n",
+		r->name, partnames[r->pos], r->ops, r->mean, r->p50, r->p90,
+		r->p99, r->max, r->allocs, r->syscalls,
+		i < nresults - 1 ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+}
+
+static int selected(char *option, char **only, int nonly)
+{
+    int i;
+
+    for (i = 0; i < nonly; i++)
+	if (!strcmp(option, only[i]))
+	    return(1);
+    return(nonly == 0);
+}
+
+/* Performance gate */
+
+struct textbuf {
+    char *buf;
+    size_t len, size;
+};
+
+static void tb_add(struct textbuf *tb, const char *str)
+{
+    size_t n = strlen(str);
+
+    if (tb->len + n + 1 > tb->size) {
+	while (tb->len + n + 1 > tb->size)
+	    tb->size = tb->size ? tb->size * 2 : 64 * 1024;
+	if ((tb->buf = realloc(tb->buf, tb->size)) == NULL) {
+	    fprintf(stderr, "wn-bench: out of memory\n");
+	    exit(-1);
+	}
+    }
+    memcpy(tb->buf + tb->len, str, n + 1);
+    tb->len += n;
+}
+
+/* Run search as wn does - on the word, then on each of its base
+   forms - and collect the output and sense counts in tb */
+
+static void gate_search(char *word, int pos, int search, struct textbuf *tb)
+{
+    char wbuf[WORDBUF], cnt[32], *morph;
+
+    tb->len = 0;
+    strcpy(wbuf, word);
+    tb_add(tb, findtheinfo(wbuf, pos, search, ALLSENSES));
+    sprintf(cnt, "\n#%d\n", wnresults.printcnt);
+    tb_add(tb, cnt);
+    if ((morph = morphstr(wbuf, pos)) != NULL)
+	do {
+	    tb_add(tb, findtheinfo(morph, pos, search, ALLSENSES));
+	    sprintf(cnt, "\n#%d\n", wnresults.printcnt);
+	    tb_add(tb, cnt);
+	} while ((morph = morphstr(NULL, pos)) != NULL);
+}
+
+struct gateresult {
+    char *option;
+    int pos;
+    long words;
+    double legacy, accel;	/* seconds */
+    long diffs;
+    long cycles;		/* differences where legacy hit a cycle */
+    long refdiffs;		/* differences from the -ref wn */
+};
+
+static char *refwn;		/* wn of an earlier release, or NULL */
+static char *thiswn;		/* wn built with this library */
+
+/* Run wn on word with search option, as the command line would, and
+   collect its output and exit status in tb.  Returns -1 if it can't be
+   run. */
+
+static int wn_output(char *wn, char *word, char *option, struct textbuf *tb)
+{
+#ifdef _WIN32
+    return(-1);
+#else
+    char buf[BUFSIZ];
+    int fd[2], status;
+    ssize_t n;
+    pid_t pid;
+
+    tb->len = 0;
+    tb_add(tb, "");
+    if (pipe(fd) < 0)
+	return(-1);
+    if ((pid = fork()) < 0) {
+	close(fd[0]);
+	close(fd[1]);
+	return(-1);
+    }
+    if (pid == 0) {
+	dup2(fd[1], 1);
+	dup2(fd[1], 2);
+	close(fd[0]);
+	close(fd[1]);
+	execlp(wn, wn, word, option, (char *)NULL);
+	_exit(127);
+    }
+    close(fd[1]);
+    while ((n = read(fd[0], buf, sizeof(buf) - 1)) > 0) {
+	buf[n] = '\0';
+	tb_add(tb, buf);
+    }
+    close(fd[0]);
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+	WEXITSTATUS(status) == 127)
+	return(-1);
+    sprintf(buf, "\n#%d\n", WEXITSTATUS(status));
+    tb_add(tb, buf);
+    return(0);
+#endif
+}
+
+static long cyclemsgs;		/* cycle warnings from the library */
+
+static int quiet_message(char *msg)
+{
+    if (strstr(msg, "Cycle detected"))
+	cyclemsgs++;
+    return(0);
+}
+
+static int gate_run(char *option, int pos, int search, struct gateresult *g)
+{
+    static struct textbuf legacy, accel, ref, cur;
+    static int ndiffs;
+    double start;
+    long i;
+
+    g->option = option;
+    g->pos = pos;
+    g->words = ncorpus[pos];
+    g->legacy = g->accel = 0.0;
+    g->diffs = g->cycles = g->refdiffs = 0;
+
+    for (i = 0; i < ncorpus[pos]; i++) {
+	cyclemsgs = 0;
+	legacyflag = 1;
+	start = nanotime();
+	gate_search(corpus[pos][i].word, pos, search, &legacy);
+	g->legacy += nanotime() - start;
+
+	legacyflag = 0;
+	start = nanotime();
+	gate_search(corpus[pos][i].word, pos, search, &accel);
+	g->accel += nanotime() - start;
+
+	if (refwn) {
+	    if (wn_output(refwn, corpus[pos][i].word, option, &ref) ||
+		wn_output(thiswn, corpus[pos][i].word, option, &cur)) {
+		fprintf(stderr, "wn-bench: cannot run %s or %s\n",
+			refwn, thiswn);
+		exit(-1);
+	    }
+	    /* A cycle now stops at the repeated synset, not MAXDEPTH */
+	    if (!cyclemsgs && (ref.len != cur.len ||
+			       memcmp(ref.buf, cur.buf, ref.len))) {
+		g->refdiffs++;
+		if (ndiffs++ < MAXDIFFS)
+		    fprintf(stderr, "wn-bench: %s %s %s: output differs "
+			    "from %s\n", option, partnames[pos],
+			    corpus[pos][i].word, refwn);
+	    }
+	}
+
+	if (legacy.len == accel.len && !memcmp(legacy.buf, accel.buf, legacy.len))
+	    continue;
+	if (cyclemsgs)
+	    g->cycles++;
+	else {
+	    g->diffs++;
+	    if (ndiffs++ < MAXDIFFS)
+		fprintf(stderr, "wn-bench: %s %s %s: output differs\n",
+			option, partnames[pos], corpus[pos][i].word);
+	}
+    }
+    g->legacy /= 1e9;
+    g->accel /= 1e9;
+
+    printf("%-8s %-5s %8ld %12.0f %12.0f %8.2f %6ld %6ld %6ld\n",
+	   option, partnames[pos], g->words,
+	   g->legacy > 0 ? g->words / g->legacy : 0.0,
+	   g->accel > 0 ? g->words / g->accel : 0.0,
+	   g->accel > 0 ? g->legacy / g->accel : 0.0, g->diffs, g->cycles,
+	   g->refdiffs);
+    fflush(stdout);
+    return(1);
+}
+
+static int gate(double ratio, char **only, int nonly, char *outfile)
+{
+    struct gateresult *g;
+    double legacy = 0.0, accel = 0.0, speedup;
+    long diffs = 0, cycles = 0, refdiffs = 0;
+    int i, pos, n = 0;
+    FILE *fp;
+
+    g = malloc(4 * sizeof(optlist) / sizeof(optlist[0]) * sizeof(*g));
+
+    printf("%-8s %-5s %8s %12s %12s %8s %6s %6s %6s\n",
+	   "search", "pos", "words", "legacy q/s", "accel q/s", "speedup",
+	   "diffs", "cycles", "ref");
+    for (i = 0; optlist[i].option; i++) {
+	if (!searched(i) || !selected(optlist[i].option, only, nonly))
+	    continue;
+	for (pos = 1; pos <= NUMPARTS; pos++) {
+	    if (optlist[i].pos != ALL_POS && optlist[i].pos != pos)
+		continue;
+	    if (ncorpus[pos] == 0)
+		continue;
+	    gate_run(optlist[i].option, pos, optlist[i].search, &g[n]);
+	    legacy += g[n].legacy;
+	    accel += g[n].accel;
+	    diffs += g[n].diffs;
+	    cycles += g[n].cycles;
+	    refdiffs += g[n].refdiffs;
+	    n++;
+	}
+    }
+    speedup = accel > 0 ? legacy / accel : 0.0;
+
+    if (outfile) {
+	if ((fp = fopen(outfile, "w")) == NULL) {
+	    fprintf(stderr, "wn-bench: cannot open %s\n", outfile);
+	    exit(-1);
+	}
+	fprintf(fp, "{\n  \"release\": \"%s\",\n  \"ratio\": %.3f,\n"
+		"  \"speedup\": %.3f,\n  \"diffs\": %ld,\n  \"cycles\": %ld,\n"
+		"  \"ref_diffs\": %ld,\n  \"results\": [\n", wnrelease, ratio,
+		speedup, diffs, cycles, refdiffs);
+	for (i = 0; i < n; i++)
+	    fprintf(fp, "    {\"search\": \"%s\", \"pos\": \"%s\", "
+		    "\"words\": %ld, \"legacy_s\": %.6f, \"accel_s\": %.6f, "
+		    "\"diffs\": %ld, \"cycles\": %ld, \"ref_diffs\": %ld}%s\n",
+		    g[i].option, partnames[g[i].pos], g[i].words,
+		    g[i].legacy, g[i].accel, g[i].diffs, g[i].cycles,
+		    g[i].refdiffs, i < n - 1 ? "," : "");
+	fprintf(fp, "  ]\n}\n");
+	fclose(fp);
+    }
+
+    printf("\nlegacy %.3fs, accelerated %.3fs, speedup %.2f (required %.2f), "
+	   "%ld differences (%ld at cycles)\n", legacy, accel, speedup, ratio,
+	   diffs, cycles);
+    if (refwn)
+	printf("%ld differences from %s\n", refdiffs, refwn);
+    if (diffs || refdiffs || speedup < ratio) {
+	printf("FAIL\n");
+	return(1);
+    }
+    printf("PASS\n");
+    return(0);
+}
+
+static void printusage(void)
+{
+    fprintf(stderr, "usage: wn-bench [-n#] [-r#] [-micro | -macro] [-s searchtype...] [-o file]\n");
+    fprintf(stderr, "       wn-bench -gate [-ratio r] [-ref wn [-wn wn]] [-n#] [-s searchtype...] [-o file]\n");
+    fprintf(stderr, "\t-n#\t\tSample # words from each index file (default %d)\n",
+	    DEFAULTSAMPLES);
+    fprintf(stderr, "\t-r#\t\tMake # passes over the sample (default %d)\n",
+	    DEFAULTREPS);
+    fprintf(stderr, "\t-micro\t\tRun only the lookup primitive benchmarks\n");
+    fprintf(stderr, "\t-macro\t\tRun only the findtheinfo() benchmarks\n");
+    fprintf(stderr, "\t-s searchtype\tRun only this findtheinfo() search, e.g. -s -hypen\n");
+    fprintf(stderr, "\t-o file\t\tWrite results to file as JSON\n");
+    fprintf(stderr, "\t-gate\t\tCompare legacy and accelerated search code over\n"
+	    "\t\t\tevery lemma (or -n sample); fail on any difference\n");
+    fprintf(stderr, "\t-ratio r\tWith -gate, also fail if accelerated code is less\n"
+	    "\t\t\tthan r times as fast (default %.1f)\n", DEFAULTRATIO);
+    fprintf(stderr, "\t-ref wn\t\tWith -gate, also fail if wn's output differs from\n"
+	    "\t\t\tthat of this wn, e.g. one built from an earlier release\n");
+    fprintf(stderr, "\t-wn wn\t\tThe wn to compare with -ref (default: the one\n"
+	    "\t\t\tbeside wn-bench)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int i, pos, samples = DEFAULTSAMPLES, reps = DEFAULTREPS;
+    int micro = 1, macro = 1, gateflag = 0, nflag = 0;
+    char *outfile = NULL, **only, *p;
+    int nonly = 0;
+    double ratio = DEFAULTRATIO;
+    long s0;
+
+    only = malloc(argc * sizeof(char *));
+
+    for (i = 1; i < argc; i++) {
+	if (!strncmp("-n", argv[i], 2) && atoi(argv[i] + 2) > 0) {
+	    samples = atoi(argv[i] + 2);
+	    nflag = 1;
+	} else if (!strcmp("-gate", argv[i]))
+	    gateflag = 1;
+	else if (!strcmp("-ratio", argv[i]) && i + 1 < argc &&
+		 atof(argv[i + 1]) > 0)
+	    ratio = atof(argv[++i]);
+	else if (!strncmp("-r", argv[i], 2) && atoi(argv[i] + 2) > 0)
+	    reps = atoi(argv[i] + 2);
+	else if (!strcmp("-micro", argv[i]))
+	    macro = 0;
+	else if (!strcmp("-macro", argv[i]))
+	    micro = 0;
+	else if (!strcmp("-s", argv[i]) && i + 1 < argc)
+	    only[nonly++] = argv[++i];
+	else if (!strcmp("-o", argv[i]) && i + 1 < argc)
+	    outfile = argv[++i];
+	else if (!strcmp("-ref", argv[i]) && i + 1 < argc)
+	    refwn = argv[++i];
+	else if (!strcmp("-wn", argv[i]) && i + 1 < argc)
+	    thiswn = argv[++i];
+	else {
+	    printusage();
+	    exit(-1);
+	}
+    }
+
+    if (wninit()) {
+	fprintf(stderr, "wn-bench: Fatal error - cannot open WordNet database\n");
+	exit(-1);
+    }
+    display_message = quiet_message;	/* e.g. cycle warnings */
+
+    if (gateflag) {
+	if (refwn && thiswn == NULL) {
+	    /* The wn built beside this wn-bench */
+	    thiswn = malloc(strlen(argv[0]) + 3);
+	    strcpy(thiswn, argv[0]);
+	    if ((p = strrchr(thiswn, '/')) != NULL)
+		strcpy(p + 1, "wn");
+	    else
+		strcpy(thiswn, "wn");
+	}
+	load_corpus(nflag ? samples : 0);
+	return(gate(ratio, only, nonly, outfile));
+    }
+
+    load_corpus(samples);
+    maxtimes = (long)samples * reps;
+    times = malloc(maxtimes * sizeof(*times));
+
+    s0 = syscalls();
+    syscall_overhead = s0 < 0 ? 0 : syscalls() - s0;
+
+    printf("%-14s %-5s %8s %12s %12s %12s %12s %10s %10s\n",
+	   "benchmark", "pos", "ops", "ns/op", "p50", "p99", "max",
+	   "allocs/op", "sysc/op");
+
+    if (micro)
+	for (pos = 1; pos <= NUMPARTS; pos++) {
+	    run("bin_search", pos, b_bin_search, 0, reps);
+	    run("index_lookup", pos, b_index_lookup, 0, reps);
+	    run("getindex", pos, b_getindex, 0, reps);
+	    run("read_synset", pos, b_read_synset, 0, reps);
+	    run("morphstr", pos, b_morphstr, 0, reps);
+	    run("is_defined", pos, b_is_defined, 0, reps);
+	}
+
+    if (macro)
+	for (i = 0; optlist[i].option; i++) {
+	    if (!searched(i) || !selected(optlist[i].option, only, nonly))
+		continue;
+	    if (optlist[i].pos == ALL_POS) {
+		for (pos = 1; pos <= NUMPARTS; pos++)
+		    run(optlist[i].option, pos, b_findtheinfo,
+			optlist[i].search, reps);
+	    } else
+		run(optlist[i].option, optlist[i].pos, b_findtheinfo,
+		    optlist[i].search, reps);
+	}
+
+    if (outfile)
+	write_json(outfile, samples, reps);
+    return(0);
+}
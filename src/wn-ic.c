@@ -0,0 +1,68 @@
+/*
+
+  wn-ic.c - build the information content table
+
+  Counts how many times the senses of each synset were tagged, from
+  cntlist.rev, propagates the counts up the hypernym hierarchy and
+  writes the information content of every synset to ic.dat in the
+  database directory, or the file given with -o.  The table is read
+  by wn_ic_load() for the Resnik, Lin and Jiang-Conrath similarity
+  measures.  It must be rebuilt whenever the database changes.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wn.h"
+
+static int error_message(char *msg)
+{
+    fprintf(stderr, "%s", msg);
+    return(0);
+}
+
+static void printusage(void)
+{
+    fprintf(stderr, "usage: wn-ic [-o file]\n");
+    fprintf(stderr, "\t-o file\tWrite table to file (default ic.dat in the database directory)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    char *file = NULL;
+    int i;
+
+    display_message = error_message;
+
+    for (i = 1; i < argc; i++) {
+	if (!strcmp(argv[i], "-o") && i + 1 < argc)
+	    file = argv[++i];
+	else {
+	    printusage();
+	    exit(-1);
+	}
+    }
+
+    if (wninit()) {
+	display_message("wn-ic: Fatal error - cannot open WordNet database\n");
+	exit(-1);
+    }
+    if (cntlistfp == NULL)
+	fprintf(stderr, "wn-ic: no cntlist.rev, every synset counted once\n");
+    if (wn_graph_load() != 0) {
+	display_message("wn-ic: Fatal error - cannot load pointer graph\n");
+	exit(-1);
+    }
+    if (wn_ic_build(file) != 0) {
+	display_message("wn-ic: Fatal error - cannot build information content table\n");
+	exit(-1);
+    }
+    if (wn_ic_load(file) != 0) {
+	display_message("wn-ic: Fatal error - cannot read back information content table\n");
+	exit(-1);
+    }
+    printf("%ld synsets\n", wn_synset_count());
+    wn_ic_free();
+    exit(0);
+}
@@ -0,0 +1,556 @@
+/*
+
+  wn-serve.c - WordNet query daemon
+
+  Opens the database once and answers search requests from local
+  clients over a Unix domain socket.  Connections are handled by a
+  fixed pool of threads.  The WordNet library keeps its search state
+  in static buffers, so the library calls themselves are serialized
+  with a single lock; socket I/O and formatting run concurrently.
+
+  Protocol: one request per line, one framed response per request.
+
+    search word=W pos=P type=T [sense=N] [flags=gaos] [format=text|json]
+    defined word=W
+    stats
+    quit
+
+  A request line longer than REQBUF gets a single ERR response.  A
+  connection with no request for the idle timeout is closed, so idle
+  clients don't hold the worker threads.
+
+  Every response is either "ERR message\n" or "OK nbytes\n" followed
+  by exactly nbytes of payload.  For a text search the payload is one
+  record per word form searched (the word itself, then each base form
+  found by morphstr()):
+
+    form WORD SENSES NBYTES\n<NBYTES of findtheinfo() output>
+
+  A json search returns the findtheinfo_ds() result as a JSON document.
+  "defined" returns "defined POS WORD MASK" lines, one per form that
+  has any searches, where MASK is the value of is_defined().  "stats"
+  returns "name value" lines.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "wn.h"
+
+#define DEFAULTSOCKET	"/tmp/wn-serve.sock"
+#define DEFAULTTHREADS	4
+#define DEFAULTIDLE	60
+#define REQBUF		1024
+#define MAXQUEUE	64
+
+/* Growable output buffer for building responses */
+
+struct outbuf {
+    char *buf;
+    size_t len, size;
+};
+
+static void out_append(struct outbuf *ob, const char *str, size_t len)
+{
+    if (ob->len + len + 1 > ob->size) {
+	while (ob->len + len + 1 > ob->size)
+	    ob->size = ob->size ? ob->size * 2 : 4096;
+	ob->buf = realloc(ob->buf, ob->size);
+	if (ob->buf == NULL) {
+	    fprintf(stderr, "wn-serve: out of memory\n");
+	    exit(-1);
+	}
+    }
+    memcpy(ob->buf + ob->len, str, len);
+    ob->len += len;
+    ob->buf[ob->len] = '\0';
+}
+
+static void out_str(struct outbuf *ob, const char *str)
+{
+    out_append(ob, str, strlen(str));
+}
+
+static void out_fmt(struct outbuf *ob, const char *fmt, ...)
+{
+    char tbuf[SMLINEBUF];
+    va_list args;
+    int n;
+
+    va_start(args, fmt);
+    n = vsnprintf(tbuf, sizeof(tbuf), fmt, args);
+    va_end(args);
+    if (n > 0)
+	out_append(ob, tbuf, n < (int)sizeof(tbuf) ? (size_t)n : sizeof(tbuf) - 1);
+}
+
+static void out_json_str(struct outbuf *ob, const char *str)
+{
+    char tbuf[8];
+
+    out_str(ob, "\"");
+    for (; str && *str; str++) {
+	switch (*str) {
+	case '"':  out_str(ob, "\\\""); break;
+	case '\\': out_str(ob, "\\\\"); break;
+	case '\n': out_str(ob, "\\n"); break;
+	case '\t': out_str(ob, "\\t"); break;
+	default:
+	    if ((unsigned char)*str < 32) {
+		snprintf(tbuf, sizeof(tbuf), "\\u%04x", *str);
+		out_str(ob, tbuf);
+	    } else
+		out_append(ob, str, 1);
+	}
+    }
+    out_str(ob, "\"");
+}
+
+/* Server counters */
+
+static struct {
+    pthread_mutex_t lock;
+    unsigned long connections;	/* connections accepted */
+    unsigned long active;	/* connections being served */
+    unsigned long requests;	/* requests received */
+    unsigned long searches;	/* search requests */
+    unsigned long errors;	/* requests answered with ERR */
+    unsigned long bytesout;	/* payload bytes sent */
+    double searchtime;		/* seconds spent in library calls */
+} counters = { PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, 0, 0, 0, 0.0 };
+
+#define COUNT(field, n) do { \
+    pthread_mutex_lock(&counters.lock); \
+    counters.field += (n); \
+    pthread_mutex_unlock(&counters.lock); \
+} while (0)
+
+static pthread_mutex_t wnlock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return(tv.tv_sec + tv.tv_usec / 1e6);
+}
+
+/* Request parsing */
+
+struct request {
+    char cmd[16];
+    char word[WORDBUF];
+    int pos;
+    int type;
+    int sense;
+    char flags[8];
+    char format[8];
+};
+
+static int parse_request(char *line, struct request *req)
+{
+    char *tok;
+
+    memset(req, 0, sizeof(*req));
+    snprintf(req->format, sizeof(req->format), "text");
+    line[strcspn(line, "\r\n")] = '\0';
+
+    if ((tok = strtok(line, " ")) == NULL)
+	return(0);
+    snprintf(req->cmd, sizeof(req->cmd), "%s", tok);
+    while ((tok = strtok(NULL, " ")) != NULL) {
+	if (!strncmp(tok, "word=", 5))
+	    snprintf(req->word, sizeof(req->word), "%s", tok + 5);
+	else if (!strncmp(tok, "pos=", 4))
+	    req->pos = atoi(tok + 4);
+	else if (!strncmp(tok, "type=", 5))
+	    req->type = atoi(tok + 5);
+	else if (!strncmp(tok, "sense=", 6))
+	    req->sense = atoi(tok + 6);
+	else if (!strncmp(tok, "flags=", 6))
+	    snprintf(req->flags, sizeof(req->flags), "%s", tok + 6);
+	else if (!strncmp(tok, "format=", 7))
+	    snprintf(req->format, sizeof(req->format), "%s", tok + 7);
+	else
+	    return(0);
+    }
+    return(1);
+}
+
+/* Set library output flags from request.  Caller holds wnlock. */
+
+static void set_flags(const char *flags)
+{
+    dflag = strchr(flags, 'g') != NULL;
+    fileinfoflag = strchr(flags, 'a') != NULL;
+    offsetflag = strchr(flags, 'o') != NULL;
+    wnsnsflag = strchr(flags, 's') != NULL;
+}
+
+static void json_synsets(struct outbuf *ob, SynsetPtr synptr)
+{
+    int i, first = 1;
+
+    out_str(ob, "[");
+    for (; synptr; synptr = synptr->nextss) {
+	if (!first)
+	    out_str(ob, ",");
+	first = 0;
+	out_fmt(ob, "{\"pos\":\"%s\",\"offset\":%ld,\"lexfile\":",
+		synptr->pos, synptr->hereiam);
+	out_json_str(ob, lexfiles[synptr->fnum]);
+	out_str(ob, ",\"words\":[");
+	for (i = 0; i < synptr->wcount; i++) {
+	    if (i)
+		out_str(ob, ",");
+	    out_json_str(ob, synptr->words[i]);
+	}
+	out_str(ob, "],\"senses\":[");
+	for (i = 0; i < synptr->wcount; i++)
+	    out_fmt(ob, i ? ",%d" : "%d", synptr->wnsns[i]);
+	out_str(ob, "],\"gloss\":");
+	out_json_str(ob, synptr->defn ? synptr->defn : "");
+	if (synptr->ptrlist) {
+	    out_str(ob, ",\"ptrs\":");
+	    json_synsets(ob, synptr->ptrlist);
+	}
+	out_str(ob, "}");
+    }
+    out_str(ob, "]");
+}
+
+static int do_search(struct request *req, struct outbuf *ob)
+{
+    char word[WORDBUF], *morph_word, *outbuf;
+    SynsetPtr synlist, form;
+    int first = 1;
+    double start;
+
+    if (req->word[0] == '\0' || req->pos < 1 || req->pos > NUMPARTS ||
+	req->type == 0 || abs(req->type) > MAXSEARCH)
+	return(0);
+
+    snprintf(word, sizeof(word), "%s", req->word);
+    strtolower(strsubst(word, ' ', '_'));
+
+    pthread_mutex_lock(&wnlock);
+    start = now();
+    set_flags(req->flags);
+
+    if (!strcmp(req->format, "json")) {
+	out_str(ob, "{\"word\":");
+	out_json_str(ob, word);
+	out_fmt(ob, ",\"pos\":\"%s\",\"forms\":[", partnames[req->pos]);
+	synlist = findtheinfo_ds(word, req->pos, req->type, req->sense);
+	for (form = synlist; form; form = form->nextform) {
+	    if (!first)
+		out_str(ob, ",");
+	    first = 0;
+	    json_synsets(ob, form);
+	}
+	out_str(ob, "]}\n");
+	if (synlist)
+	    free_syns(synlist);
+    } else {
+	outbuf = findtheinfo(word, req->pos, req->type, req->sense);
+	out_fmt(ob, "form %s %d %lu\n", word, wnresults.printcnt,
+		(unsigned long)strlen(outbuf));
+	out_str(ob, outbuf);
+	if ((morph_word = morphstr(word, req->pos)) != NULL)
+	    do {
+		outbuf = findtheinfo(morph_word, req->pos, req->type,
+				     req->sense);
+		out_fmt(ob, "form %s %d %lu\n", morph_word, wnresults.printcnt,
+			(unsigned long)strlen(outbuf));
+		out_str(ob, outbuf);
+	    } while ((morph_word = morphstr(NULL, req->pos)) != NULL);
+    }
+
+    COUNT(searchtime, now() - start);
+    pthread_mutex_unlock(&wnlock);
+    COUNT(searches, 1);
+    return(1);
+}
+
+static int do_defined(struct request *req, struct outbuf *ob)
+{
+    char word[WORDBUF], *morph_word;
+    unsigned int search;
+    int pos;
+
+    if (req->word[0] == '\0')
+	return(0);
+
+    snprintf(word, sizeof(word), "%s", req->word);
+    strtolower(strsubst(word, ' ', '_'));
+
+    pthread_mutex_lock(&wnlock);
+    for (pos = 1; pos <= NUMPARTS; pos++) {
+	search = is_defined(word, pos);
+	out_fmt(ob, "defined %d %s %u\n", pos, word, search);
+	if ((morph_word = morphstr(word, pos)) != NULL)
+	    do {
+		search = is_defined(morph_word, pos);
+		out_fmt(ob, "defined %d %s %u\n", pos, morph_word, search);
+	    } while ((morph_word = morphstr(NULL, pos)) != NULL);
+    }
+    pthread_mutex_unlock(&wnlock);
+    return(1);
+}
+
+static void do_stats(struct outbuf *ob)
+{
+    WNStats *st;
+
+    pthread_mutex_lock(&wnlock);
+    if ((st = wn_stats(WNSTATS_TOTAL)) != NULL) {
+	out_fmt(ob, "lib_binsearches %lu\n", st->binsearches);
+	out_fmt(ob, "lib_probes %lu\n", st->probes);
+	out_fmt(ob, "lib_bytesread %lu\n", st->bytesread);
+	out_fmt(ob, "lib_indexparsed %lu\n", st->indexparsed);
+	out_fmt(ob, "lib_synsetsparsed %lu\n", st->synsetsparsed);
+	out_fmt(ob, "lib_cachehits %lu\n", st->cachehits);
+	out_fmt(ob, "lib_cachemisses %lu\n", st->cachemisses);
+	out_fmt(ob, "lib_allocs %lu\n", st->allocs);
+    }
+    pthread_mutex_unlock(&wnlock);
+
+    pthread_mutex_lock(&counters.lock);
+    out_fmt(ob, "connections %lu\n", counters.connections);
+    out_fmt(ob, "active %lu\n", counters.active);
+    out_fmt(ob, "requests %lu\n", counters.requests);
+    out_fmt(ob, "searches %lu\n", counters.searches);
+    out_fmt(ob, "errors %lu\n", counters.errors);
+    out_fmt(ob, "bytesout %lu\n", counters.bytesout);
+    out_fmt(ob, "searchtime %.6f\n", counters.searchtime);
+    pthread_mutex_unlock(&counters.lock);
+}
+
+static int write_all(int fd, const char *buf, size_t len)
+{
+    ssize_t n;
+
+    while (len > 0) {
+	if ((n = write(fd, buf, len)) < 0) {
+	    if (errno == EINTR)
+		continue;
+	    return(-1);
+	}
+	buf += n;
+	len -= n;
+    }
+    return(0);
+}
+
+static int respond(int fd, struct outbuf *ob, int ok, const char *errmsg)
+{
+    char hdr[64];
+
+    if (!ok) {
+	COUNT(errors, 1);
+	snprintf(hdr, sizeof(hdr), "ERR %s\n", errmsg);
+	return(write_all(fd, hdr, strlen(hdr)));
+    }
+    snprintf(hdr, sizeof(hdr), "OK %lu\n", (unsigned long)ob->len);
+    COUNT(bytesout, ob->len);
+    if (write_all(fd, hdr, strlen(hdr)))
+	return(-1);
+    return(write_all(fd, ob->buf ? ob->buf : "", ob->len));
+}
+
+static int idletime = DEFAULTIDLE;
+
+static void serve_client(int fd)
+{
+    FILE *in;
+    char line[REQBUF];
+    struct request req;
+    struct outbuf ob = { NULL, 0, 0 };
+    struct timeval tv;
+    int c, ok;
+
+    /* A read that times out ends the fgets() loop below */
+    tv.tv_sec = idletime;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    if ((in = fdopen(fd, "r")) == NULL) {
+	close(fd);
+	return;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+	COUNT(requests, 1);
+	ob.len = 0;
+	if (strchr(line, '\n') == NULL && !feof(in)) {
+	    /* Discard the rest of an overlong line */
+	    while ((c = getc(in)) != EOF && c != '\n')
+		;
+	    ok = respond(fd, &ob, 0, "request too long");
+	} else if (!parse_request(line, &req))
+	    ok = respond(fd, &ob, 0, "malformed request");
+	else if (!strcmp(req.cmd, "quit"))
+	    break;
+	else if (!strcmp(req.cmd, "search"))
+	    ok = respond(fd, &ob, do_search(&req, &ob), "invalid search");
+	else if (!strcmp(req.cmd, "defined"))
+	    ok = respond(fd, &ob, do_defined(&req, &ob), "invalid word");
+	else if (!strcmp(req.cmd, "stats")) {
+	    do_stats(&ob);
+	    ok = respond(fd, &ob, 1, NULL);
+	} else
+	    ok = respond(fd, &ob, 0, "unknown command");
+	if (ok < 0)
+	    break;
+    }
+    free(ob.buf);
+    fclose(in);
+}
+
+/* Connection queue shared by the accept loop and the worker pool */
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    int fds[MAXQUEUE];
+    int head, count;
+} queue = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, { 0 }, 0, 0 };
+
+static void *worker(void *arg)
+{
+    int fd;
+
+    (void)arg;
+    for (;;) {
+	pthread_mutex_lock(&queue.lock);
+	while (queue.count == 0)
+	    pthread_cond_wait(&queue.ready, &queue.lock);
+	fd = queue.fds[queue.head];
+	queue.head = (queue.head + 1) % MAXQUEUE;
+	queue.count--;
+	pthread_mutex_unlock(&queue.lock);
+
+	COUNT(active, 1);
+	serve_client(fd);
+	pthread_mutex_lock(&counters.lock);
+	counters.active--;
+	pthread_mutex_unlock(&counters.lock);
+    }
+    return(NULL);
+}
+
+static const char *sockpath = DEFAULTSOCKET;
+
+static void shutdown_server(int sig)
+{
+    (void)sig;
+    unlink(sockpath);
+    _exit(0);
+}
+
+static int error_message(char *msg)
+{
+    fprintf(stderr, "%s", msg);
+    return(0);
+}
+
+static void printusage(void)
+{
+    fprintf(stderr, "usage: wn-serve [-s socket] [-t threads] [-i seconds]\n");
+    fprintf(stderr, "\t-s socket\tListen on socket (default %s)\n",
+	    DEFAULTSOCKET);
+    fprintf(stderr, "\t-t threads\tNumber of worker threads (default %d)\n",
+	    DEFAULTTHREADS);
+    fprintf(stderr, "\t-i seconds\tClose idle connections after seconds (default %d)\n",
+	    DEFAULTIDLE);
+}
+
+int main(int argc, char *argv[])
+{
+    struct sockaddr_un addr;
+    pthread_t tid;
+    int i, fd, listenfd, nthreads = DEFAULTTHREADS;
+
+    display_message = error_message;
+
+    for (i = 1; i < argc; i++) {
+	if (!strcmp(argv[i], "-s") && i + 1 < argc)
+	    sockpath = argv[++i];
+	else if (!strcmp(argv[i], "-t") && i + 1 < argc &&
+		 atoi(argv[i + 1]) > 0)
+	    nthreads = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-i") && i + 1 < argc &&
+		 atoi(argv[i + 1]) > 0)
+	    idletime = atoi(argv[++i]);
+	else {
+	    printusage();
+	    exit(-1);
+	}
+    }
+
+    if (wninit()) {
+	display_message("wn-serve: Fatal error - cannot open WordNet database\n");
+	exit(-1);
+    }
+
+    if (strlen(sockpath) >= sizeof(addr.sun_path)) {
+	fprintf(stderr, "wn-serve: socket path too long: %s\n", sockpath);
+	exit(-1);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", sockpath);
+
+    if ((listenfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+	perror("wn-serve: socket");
+	exit(-1);
+    }
+    unlink(sockpath);
+    if (bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	listen(listenfd, MAXQUEUE) < 0) {
+	perror("wn-serve: bind");
+	exit(-1);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, shutdown_server);
+    signal(SIGTERM, shutdown_server);
+
+    for (i = 0; i < nthreads; i++)
+	if (pthread_create(&tid, NULL, worker, NULL) == 0)
+	    pthread_detach(tid);
+
+    for (;;) {
+	if ((fd = accept(listenfd, NULL, NULL)) < 0) {
+	    if (errno == EINTR)
+		continue;
+	    perror("wn-serve: accept");
+	    break;
+	}
+	COUNT(connections, 1);
+	pthread_mutex_lock(&queue.lock);
+	if (queue.count == MAXQUEUE) {
+	    pthread_mutex_unlock(&queue.lock);
+	    write_all(fd, "ERR server busy\n", 16);
+	    close(fd);
+	    continue;
+	}
+	queue.fds[(queue.head + queue.count) % MAXQUEUE] = fd;
+	queue.count++;
+	pthread_cond_signal(&queue.ready);
+	pthread_mutex_unlock(&queue.lock);
+    }
+
+    unlink(sockpath);
+    return(0);
+}
@@ -7,79 +7,19 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
 #include "wn.h"
+#include "wnopts.h"
 
 static char *Id = "$Id: wn.c,v 1.13 2005/01/31 19:19:09 wn Rel $";
 
-static struct {
-    char *option;		/* user's search request */
-    int search;			/* search to pass findtheinfo() */
-    int pos;			/* part-of-speech to pass findtheinfo() */
-    int helpmsgidx;		/* index into help message table */
-    char *label;		/* text for search header message */
-} *optptr, optlist[] = {
-    { "-synsa", SIMPTR,	ADJ, 0, "Similarity" },
-    { "-antsa", ANTPTR,	ADJ, 1, "Antonyms" },
-    { "-perta", PERTPTR, ADJ, 0, "Pertainyms" },
-    { "-attra", ATTRIBUTE, ADJ, 2, "Attributes" },
-    { "-domna", CLASSIFICATION, ADJ, 3, "Domain" },
-    { "-domta", CLASS, ADJ, 4, "Domain Terms" },
-    { "-famla", FREQ, ADJ, 5, "Familiarity" },
-    { "-grepa", WNGREP, ADJ, 6, "Grep" },
-
-    { "-synsn", HYPERPTR, NOUN, 0, "Synonyms/Hypernyms (Ordered by Estimated Frequency)" },
-    { "-antsn", ANTPTR,	NOUN, 2, "Antonyms" },
-    { "-coorn", COORDS, NOUN, 3, "Coordinate Terms (sisters)" },
-    { "-hypen", -HYPERPTR, NOUN, 4, "Synonyms/Hypernyms (Ordered by Estimated Frequency)" },
-    { "-hypon", HYPOPTR, NOUN, 5, "Hyponyms" },
-    { "-treen", -HYPOPTR, NOUN, 6, "Hyponyms" },
-    { "-holon", HOLONYM, NOUN, 7, "Holonyms" },
-    { "-sprtn", ISPARTPTR, NOUN, 7, "Part Holonyms" },
-    { "-smemn", ISMEMBERPTR, NOUN, 7, "Member Holonyms" },
-    { "-ssubn", ISSTUFFPTR, NOUN, 7, "Substance Holonyms" },
-    { "-hholn",	-HHOLONYM, NOUN, 8, "Holonyms" },
-    { "-meron", MERONYM, NOUN, 9, "Meronyms" },
-    { "-subsn", HASSTUFFPTR, NOUN, 9, "Substance Meronyms" },
-    { "-partn", HASPARTPTR, NOUN, 9, "Part Meronyms" },
-    { "-membn", HASMEMBERPTR, NOUN, 9, "Member Meronyms" },
-    { "-hmern", -HMERONYM, NOUN, 10, "Meronyms" },
-    { "-nomnn", DERIVATION, NOUN, 11, "Derived Forms" },
-    { "-derin", DERIVATION, NOUN, 11, "Derived Forms" },
-    { "-domnn", CLASSIFICATION, NOUN, 13, "Domain" },
-    { "-domtn", CLASS, NOUN, 14, "Domain Terms" },
-    { "-attrn", ATTRIBUTE, NOUN, 12, "Attributes" },
-    { "-famln", FREQ, NOUN, 15, "Familiarity" },
-    { "-grepn", WNGREP, NOUN, 16, "Grep" },
-
-    { "-synsv", HYPERPTR, VERB, 0, "Synonyms/Hypernyms (Ordered by Estimated Frequency)" },
-    { "-simsv", RELATIVES, VERB, 1, "Synonyms (Grouped by Similarity of Meaning)" },
-    { "-antsv", ANTPTR, VERB, 2, "Antonyms" },
-    { "-coorv", COORDS, VERB, 3, "Coordinate Terms (sisters)" },
-    { "-hypev", -HYPERPTR, VERB, 4, "Synonyms/Hypernyms (Ordered by Estimated Frequency)" },
-    { "-hypov", HYPOPTR, VERB, 5, "Troponyms (hyponyms)" },
-    { "-treev", -HYPOPTR, VERB, 5, "Troponyms (hyponyms)" },
-    { "-tropv", -HYPOPTR, VERB, 5, "Troponyms (hyponyms)" },
-    { "-entav", ENTAILPTR, VERB, 6, "Entailment" },
-    { "-causv", CAUSETO, VERB, 7, "\'Cause To\'" },
-    { "-nomnv", DERIVATION, VERB, 8, "Derived Forms" },
-    { "-deriv", DERIVATION, VERB, 8, "Derived Forms" },
-    { "-domnv", CLASSIFICATION, VERB, 10, "Domain" },
-    { "-domtv", CLASS, VERB, 11, "Domain Terms" },
-    { "-framv", FRAMES, VERB, 9, "Sample Sentences" },
-    { "-famlv", FREQ, VERB, 12, "Familiarity" },
-    { "-grepv", WNGREP, VERB, 13, "Grep" },
-
-    { "-synsr", SYNS, ADV, 0, "Synonyms" },
-    { "-antsr", ANTPTR, ADV, 1, "Antonyms" },
-    { "-pertr", PERTPTR, ADV, 0, "Pertainyms" },
-    { "-domnr", CLASSIFICATION, ADV, 2, "Domain" },
-    { "-domtr", CLASS, ADV, 3, "Domain Terms" },
-    { "-famlr", FREQ, ADV, 4, "Familiarity" },
-    { "-grepr", WNGREP, ADV, 5, "Grep" },
-
-    { "-over", OVERVIEW, ALL_POS, -1, "Overview" },
-    { NULL, 0, 0, 0, NULL }
-};
+static struct wnoption *optptr;
 
 struct {
     char *template;		/* template for generic search message */
@@ -123,10 +63,19 @@ struct {
 
 static int getoptidx(char *), cmdopt(char *);
 static int searchwn(int, char *[]);
+static int batchwn(int, char *[]);
 static int do_search(char *, int, int, int, char *);
+static int search_group(char *[], int, int, int, int *);
+static int print_search(int, char *, char *, void *);
 static int do_is_defined(char *);
+static int connectwn(int, char *[]);
+static int remote_search(char *, int, int, int, char *);
+static int remote_is_defined(char *);
+static FILE *serverin, *serverout;	/* wn-serve connection, if any */
+static int statsflag;		/* if set, print library counters */
 static void printusage(), printlicense(),
-       printsearches(char *, int, unsigned long);
+       printsearches(char *, int, unsigned long),
+       printstats(char *, WNStats *);
 static int error_message(char *);
 
 int main(int argc,char *argv[])
@@ -141,10 +90,19 @@ int main(int argc,char *argv[])
 	exit(-1);
     }
 
+    /* Client mode sends searches to wn-serve, so it doesn't need
+       to open the database itself */
+
+    if (!strcmp("--connect", argv[1]))
+	exit(connectwn(argc, argv));
+
     if (wninit()) {		/* open database */
 	display_message("wn: Fatal error - cannot open WordNet database\n");
 	exit (-1);
     }
+
+    if (!strcmp("--batch", argv[1]))
+	exit(batchwn(argc, argv));
     
     exit(searchwn(argc, argv));
 }
@@ -157,11 +115,11 @@ static int searchwn(int ac, char *av[])
     char tmpbuf[256];		/* buffer for constuction error messages */
     
     if (ac == 2)		/* print available searches for word */
-	exit(do_is_defined(av[1]));
+	return(do_is_defined(av[1]));
 
     /* Parse command line options once and set flags */
 
-    dflag = fileinfoflag = offsetflag = wnsnsflag = 0;
+    dflag = fileinfoflag = offsetflag = wnsnsflag = statsflag = 0;
 
     for(i = 1; i < ac; i++) {
 	if(!strcmp("-g",av[i]))
@@ -178,6 +136,16 @@ static int searchwn(int ac, char *av[])
 	    offsetflag = 1;
 	else if (!strcmp("-s", av[i]))
 	    wnsnsflag = 1;
+	else if (!strcmp("-stats", av[i]))
+	    statsflag = 1;
+    }
+
+    if (statsflag && serverin == NULL) {
+	if (wn_stats(WNSTATS_TOTAL) == NULL) {
+	    display_message("wn: -stats: library built without WN_STATS\n");
+	    statsflag = 0;
+	} else
+	    wn_stats_reset(WNSTATS_TOTAL);
     }
 
     /* Replace spaces with underscores before looking in database */
@@ -192,11 +160,25 @@ static int searchwn(int ac, char *av[])
 	    if ((i = getoptidx(av[j])) != -1) {
 		optptr = &optlist[i];
 
+		/* Searches in one part of speech that follow each other
+		   are done together, unless counters are wanted for
+		   each search */
+		if (optptr->pos != ALL_POS && serverin == NULL && !statsflag) {
+		    j = search_group(av, j, whichsense, help, &outsenses);
+		    continue;
+		}
+
 		/* print help text before search output */
 		if (help && optptr->helpmsgidx >= 0)
 		    printf("%s\n", helptext[optptr->pos][optptr->helpmsgidx]);
 
-		if (optptr->pos == ALL_POS)
+		/* The library does the whole overview in one pass,
+		   unless counters are wanted for each form */
+		if (optptr->search == OVERVIEW && optptr->pos == ALL_POS &&
+		    serverin == NULL && !statsflag) {
+		    printf("%s", wn_overview(av[1]));
+		    outsenses += wnresults.printcnt;
+		} else if (optptr->pos == ALL_POS)
 		    for (pos = 1; pos <= NUMPARTS; pos++)
 			outsenses += do_search(av[1], pos, optptr->search,
 						whichsense, optptr->label);
@@ -210,6 +192,8 @@ static int searchwn(int ac, char *av[])
 	    }
 	}
     }
+    if (statsflag && serverin == NULL)
+	printstats("all searches", wn_stats(WNSTATS_TOTAL));
     return(errcount ? -errcount : outsenses);
 }
 
@@ -219,11 +203,16 @@ static int do_search(char *searchword, int pos, int search, int whichsense,
     int totsenses = 0;
     char *morph_word, *outbuf;
 
+    if (serverin != NULL)
+	return(remote_search(searchword, pos, search, whichsense, label));
+
     outbuf = findtheinfo(searchword, pos, search, whichsense);
     totsenses += wnresults.printcnt;
     if (strlen(outbuf) > 0)
 	printf("\n%s of %s %s\n%s",
 	       label, partnames[pos], searchword, outbuf);
+    if (statsflag)
+	printstats(searchword, wn_stats(WNSTATS_QUERY));
 
     if ((morph_word = morphstr(searchword, pos)) != NULL)
 	do {
@@ -232,11 +221,533 @@ static int do_search(char *searchword, int pos, int search, int whichsense,
 	    if (strlen(outbuf) > 0) 
 		printf("\n%s of %s %s\n%s",
 		       label, partnames[pos], morph_word, outbuf);
+	    if (statsflag)
+		printstats(morph_word, wn_stats(WNSTATS_QUERY));
 	} while ((morph_word = morphstr(NULL, pos)) != NULL);
 
     return(totsenses);
 }
 
+/* Search options run together by wn_searches() */
+
+#define MAXGROUP	32
+
+struct searchgroup {
+    int opt[MAXGROUP];		/* index of each option in optlist */
+    int search[MAXGROUP];	/* search to pass wn_searches() */
+    int nopts;
+    int help;			/* if set, print help text for each */
+    int last;			/* last search output was printed for */
+};
+
+/* Do the search option av[j], and any following it for the same part
+   of speech, with one call to wn_searches().  Output is the same as
+   doing each with do_search().  Returns the index of the last option
+   done. */
+
+static int search_group(char *av[], int j, int whichsense, int help,
+			int *outsenses)
+{
+    struct searchgroup group;
+    int i, k, pos, retval;
+
+    pos = optlist[getoptidx(av[j])].pos;
+    group.nopts = 0;
+    group.help = help;
+    group.last = -1;
+    for (k = j; av[k] && group.nopts < MAXGROUP; k++) {
+	if (cmdopt(av[k]))
+	    continue;
+	if ((i = getoptidx(av[k])) == -1 || optlist[i].pos != pos)
+	    break;
+	group.opt[group.nopts] = i;
+	group.search[group.nopts++] = optlist[i].search;
+	j = k;
+    }
+
+    retval = wn_searches(av[1], pos, group.search, group.nopts,
+			 whichsense, print_search, &group);
+    if (retval >= 0)
+	*outsenses += retval;
+    else			/* out of memory - one at a time */
+	for (k = 0; k < group.nopts; k++) {
+	    optptr = &optlist[group.opt[k]];
+	    if (help && optptr->helpmsgidx >= 0)
+		printf("%s\n", helptext[optptr->pos][optptr->helpmsgidx]);
+	    *outsenses += do_search(av[1], optptr->pos, optptr->search,
+				    whichsense, optptr->label);
+	}
+    return(j);
+}
+
+/* Print output of search i of a group for word, as do_search() does */
+
+static int print_search(int i, char *word, char *outbuf, void *arg)
+{
+    struct searchgroup *group = arg;
+
+    optptr = &optlist[group->opt[i]];
+    if (i != group->last) {	/* print help text before search output */
+	if (group->help && optptr->helpmsgidx >= 0)
+	    printf("%s\n", helptext[optptr->pos][optptr->helpmsgidx]);
+	group->last = i;
+    }
+    if (strlen(outbuf) > 0)
+	printf("\n%s of %s %s\n%s",
+	       optptr->label, partnames[optptr->pos], word, outbuf);
+    return(0);
+}
+
+/* Batch mode - read "word<TAB>search-options" lines from stdin and
+   run each one as if it had been passed on the command line.  The
+   database is opened once for the whole stream.  Each result is
+   written between "#begin" and "#end" delimiter lines, in input order. */
+
+#define BATCHLINE	(4*1024)
+#define BATCHMAXARGS	64
+#define BATCHWINDOW	4	/* lines in flight per worker */
+
+/* Lines holding only white space are skipped, in either mode */
+
+#define batch_blank(line)	((line)[strspn((line), " \t\r\n")] == '\0')
+
+/* Read the next request into line.  Returns 1, 0 at end of input, or
+   -1 if the line doesn't fit, in which case the rest of it is read
+   and thrown away. */
+
+static int batch_getline(char *line)
+{
+    int c;
+
+    if (fgets(line, BATCHLINE, stdin) == NULL)
+	return(0);
+    if (strchr(line, '\n') != NULL || (c = getchar()) == EOF)
+	return(1);
+    if (c == '\n')		/* fits once the newline is dropped */
+	return(1);
+    while ((c = getchar()) != EOF && c != '\n')
+	;
+    return(-1);
+}
+
+/* Write the record of a line too long to be performed */
+
+static void batch_toolong(long lineno)
+{
+    printf("#begin %ld\n", lineno);
+    fprintf(stderr, "wn: line %ld: request longer than %d bytes\n",
+	    lineno, BATCHLINE - 1);
+    printf("#end %ld -1\n", lineno);
+}
+
+static int batch_record(long lineno, char *line)
+{
+    char *av[BATCHMAXARGS + 1], *tab, *tok;
+    int ac = 0, retval;
+
+    if (batch_blank(line))
+	return(0);
+    line[strcspn(line, "\r\n")] = '\0';
+
+    printf("#begin %ld %s\n", lineno, line);
+
+    av[ac++] = "wn";
+    if ((tab = strchr(line, '\t')) != NULL)
+	*tab++ = '\0';
+    av[ac++] = line;
+    if (tab != NULL)
+	for (tok = strtok(tab, " \t"); tok && ac < BATCHMAXARGS;
+	     tok = strtok(NULL, " \t"))
+	    av[ac++] = tok;
+    av[ac] = NULL;
+
+    retval = searchwn(ac, av);
+    printf("#end %ld %d\n", lineno, retval);
+    return(1);
+}
+
+#ifndef _WIN32
+
+struct batchworker {
+    pid_t pid;
+    FILE *in;			/* requests to worker */
+    FILE *out;			/* results from worker */
+    int dead;			/* exited or stopped reading */
+};
+
+struct batchline {
+    long lineno;
+    int worker;			/* worker it was sent to */
+};
+
+/* Worker loop.  Each result is terminated with a NUL byte so the
+   parent can tell where one record ends and the next begins. */
+
+static void batch_worker(FILE *in)
+{
+    char line[BATCHLINE];
+    long lineno;
+
+    if (re_wninit()) {		/* get our own file positions */
+	display_message("wn: Fatal error - cannot open WordNet database\n");
+	_exit(-1);
+    }
+    while (fscanf(in, "%ld ", &lineno) == 1 &&
+	   fgets(line, sizeof(line), in) != NULL) {
+	batch_record(lineno, line);
+	putchar('\0');
+	fflush(stdout);
+    }
+    fflush(stdout);
+    _exit(0);
+}
+
+/* Copy the result of line lineno from worker w.  If the worker has
+   died, end the record as a failed one and return -1. */
+
+static int batch_collect(struct batchworker *w, long lineno)
+{
+    int c, last = EOF;
+
+    while ((c = getc(w->out)) != EOF && c != '\0')
+	putchar(last = c);
+    if (c != EOF)
+	return(0);
+    w->dead = 1;
+    if (last == EOF)
+	printf("#begin %ld\n", lineno);
+    else if (last != '\n')
+	putchar('\n');
+    printf("#end %ld -1\n", lineno);
+    return(-1);
+}
+
+/* Close the pipes to the first n workers and wait for them to exit */
+
+static void batch_stop(struct batchworker *workers, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	fclose(workers[i].in);
+	fclose(workers[i].out);
+	waitpid(workers[i].pid, NULL, 0);
+    }
+}
+
+/* Perform the requests on nworkers worker processes.  Returns 0 if
+   every request was answered, -1 if not, or 1 if the workers couldn't
+   be started, in which case no input has been read. */
+
+static int batch_pool(int nworkers)
+{
+    struct batchworker *workers, *w;
+    struct batchline *pending;
+    char line[BATCHLINE];
+    long lineno = 0;
+    void (*sigpipe)(int);
+    int window, head = 0, tail = 0, inflight = 0;
+    int i, j, n, next = 0, errcount = 0;
+    int topipe[2], frompipe[2];
+
+    workers = malloc(nworkers * sizeof(*workers));
+    window = nworkers * BATCHWINDOW;
+    pending = malloc(window * sizeof(*pending));
+    if (workers == NULL || pending == NULL) {
+	free(workers);
+	free(pending);
+	return(1);
+    }
+
+    fflush(stdout);
+    for (i = 0; i < nworkers; i++) {
+	if (pipe(topipe))
+	    break;
+	if (pipe(frompipe)) {
+	    close(topipe[0]);
+	    close(topipe[1]);
+	    break;
+	}
+	if ((workers[i].pid = fork()) < 0) {
+	    close(topipe[0]);
+	    close(topipe[1]);
+	    close(frompipe[0]);
+	    close(frompipe[1]);
+	    break;
+	}
+	if (workers[i].pid == 0) {
+	    for (j = 0; j < i; j++) {
+		fclose(workers[j].in);
+		fclose(workers[j].out);
+	    }
+	    close(topipe[1]);
+	    close(frompipe[0]);
+	    dup2(frompipe[1], fileno(stdout));
+	    close(frompipe[1]);
+	    batch_worker(fdopen(topipe[0], "r"));
+	}
+	close(topipe[0]);
+	close(frompipe[1]);
+	workers[i].in = fdopen(topipe[1], "w");
+	workers[i].out = fdopen(frompipe[0], "r");
+	workers[i].dead = 0;
+    }
+    if (i < nworkers) {
+	batch_stop(workers, i);
+	free(pending);
+	free(workers);
+	return(1);
+    }
+
+    /* Requests are dealt to the workers still running round robin,
+       and their results collected in the order the lines were sent.
+       Keeping a bounded window of lines in flight means neither side
+       can fill a pipe while the other is blocked on it.  A worker
+       that dies fails the lines it still owed, and isn't sent any
+       more; writing to it must not kill wn. */
+
+    sigpipe = signal(SIGPIPE, SIG_IGN);
+    while ((n = batch_getline(line)) != 0) {
+	lineno++;
+	if (n < 0) {		/* after the lines before it */
+	    while (inflight > 0) {
+		errcount += batch_collect(&workers[pending[head].worker],
+					  pending[head].lineno) < 0;
+		head = (head + 1) % window;
+		inflight--;
+	    }
+	    batch_toolong(lineno);
+	    errcount++;
+	    continue;
+	}
+	if (batch_blank(line))
+	    continue;
+	if (inflight == window) {
+	    errcount += batch_collect(&workers[pending[head].worker],
+				      pending[head].lineno) < 0;
+	    head = (head + 1) % window;
+	    inflight--;
+	}
+	for (i = 0; i < nworkers && workers[next].dead; i++)
+	    next = (next + 1) % nworkers;
+	if (i == nworkers) {	/* none left */
+	    line[strcspn(line, "\r\n")] = '\0';
+	    printf("#begin %ld %s\n#end %ld -1\n", lineno, line, lineno);
+	    errcount++;
+	    continue;
+	}
+	w = &workers[next];
+	fprintf(w->in, "%ld %s", lineno, line);
+	if (line[strlen(line) - 1] != '\n')
+	    putc('\n', w->in);
+	if (fflush(w->in) == EOF)
+	    w->dead = 1;	/* its record fails when collected */
+	pending[tail].lineno = lineno;
+	pending[tail].worker = next;
+	tail = (tail + 1) % window;
+	inflight++;
+	next = (next + 1) % nworkers;
+    }
+    while (inflight-- > 0) {
+	errcount += batch_collect(&workers[pending[head].worker],
+				  pending[head].lineno) < 0;
+	head = (head + 1) % window;
+    }
+
+    batch_stop(workers, nworkers);
+    signal(SIGPIPE, sigpipe);
+    free(pending);
+    free(workers);
+    fflush(stdout);
+    return(errcount || ferror(stdout) ? -1 : 0);
+}
+
+#endif /* _WIN32 */
+
+static int batchwn(int ac, char *av[])
+{
+    char line[BATCHLINE];
+    long lineno = 0;
+    int i, n, nworkers = 1, errcount = 0;
+
+#ifndef _WIN32
+    nworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    for (i = 2; i < ac; i++) {
+	if (!strncmp("-j", av[i], 2) && atoi(av[i] + 2) > 0)
+	    nworkers = atoi(av[i] + 2);
+	else {
+	    display_message("wn: usage: wn --batch [-j#]\n");
+	    return(-1);
+	}
+    }
+
+#ifndef _WIN32
+    /* Do the requests here if the workers can't be started */
+    if (nworkers > 1 && (i = batch_pool(nworkers)) <= 0)
+	return(i);
+#endif
+
+    while ((n = batch_getline(line)) != 0) {
+	lineno++;
+	if (n < 0) {
+	    batch_toolong(lineno);
+	    errcount++;
+	} else
+	    batch_record(lineno, line);
+    }
+    fflush(stdout);
+    return(errcount || ferror(stdout) ? -1 : 0);
+}
+
+/* Client mode - pass searches to a running wn-serve over its Unix
+   domain socket instead of opening the database.  Command line
+   handling and output are the same as a local search. */
+
+#ifndef _WIN32
+
+static int connectwn(int ac, char *av[])
+{
+    struct sockaddr_un addr;
+    char tmpbuf[256];
+    int fd, retval;
+
+    if (ac < 4) {
+	display_message("wn: usage: wn --connect socket word [options] -searchtype...\n");
+	return(-1);
+    }
+    if (strlen(av[2]) >= sizeof(addr.sun_path)) {
+	display_message("wn: socket path too long\n");
+	return(-1);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, av[2]);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+	connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+	sprintf(tmpbuf, "wn: cannot connect to server at %.200s\n", av[2]);
+	display_message(tmpbuf);
+	return(-1);
+    }
+    serverout = fdopen(fd, "w");
+    serverin = fdopen(dup(fd), "r");
+
+    /* Drop "--connect socket" so argument positions match searchwn() */
+
+    retval = searchwn(ac - 2, av + 2);
+
+    fprintf(serverout, "quit\n");
+    fclose(serverout);
+    fclose(serverin);
+    return(retval);
+}
+
+/* Send one request and read back its payload.  Returns payload length,
+   or -1 on error.  Caller frees *payload. */
+
+static long server_request(char *request, char **payload)
+{
+    char hdr[256];
+    unsigned long len;
+
+    *payload = NULL;
+    fputs(request, serverout);
+    fflush(serverout);
+    if (fgets(hdr, sizeof(hdr), serverin) == NULL) {
+	display_message("wn: lost connection to server\n");
+	return(-1);
+    }
+    if (sscanf(hdr, "OK %lu", &len) != 1) {
+	display_message("wn: server error: ");
+	display_message(strncmp(hdr, "ERR ", 4) ? hdr : hdr + 4);
+	return(-1);
+    }
+    if ((*payload = malloc(len + 1)) == NULL ||
+	fread(*payload, 1, len, serverin) != len) {
+	display_message("wn: short response from server\n");
+	free(*payload);
+	*payload = NULL;
+	return(-1);
+    }
+    (*payload)[len] = '\0';
+    return((long)len);
+}
+
+static int remote_search(char *searchword, int pos, int search,
+			 int whichsense, char *label)
+{
+    char request[WORDBUF + 128], form[WORDBUF], *payload, *p;
+    unsigned long len;
+    int senses, n, totsenses = 0;
+
+    sprintf(request, "search word=%.*s pos=%d type=%d sense=%d flags=%s%s%s%s format=text\n",
+	    WORDBUF - 1, searchword, pos, search, whichsense,
+	    dflag ? "g" : "", fileinfoflag ? "a" : "",
+	    offsetflag ? "o" : "", wnsnsflag ? "s" : "");
+    if (server_request(request, &payload) < 0)
+	return(0);
+
+    /* One record per word form: "form WORD SENSES NBYTES\n" + text */
+
+    for (p = payload;
+	 sscanf(p, "form %255s %d %lu%n", form, &senses, &len, &n) == 3 &&
+	     p[n++] == '\n';
+	 p += n + len) {
+	totsenses += senses;
+	if (len > 0)
+	    printf("\n%s of %s %s\n%.*s",
+		   label, partnames[pos], form, (int)len, p + n);
+    }
+    free(payload);
+    return(totsenses);
+}
+
+static int remote_is_defined(char *searchword)
+{
+    char request[WORDBUF + 32], form[WORDBUF], *payload, *p;
+    unsigned int search;
+    int pos, n, found = 0;
+
+    sprintf(request, "defined word=%.*s\n", WORDBUF - 1, searchword);
+    if (server_request(request, &payload) < 0)
+	return(-1);
+
+    for (p = payload;
+	 sscanf(p, "defined %d %255s %u\n%n", &pos, form, &search, &n) == 3;
+	 p += n) {
+	if (search != 0) {
+	    printsearches(form, pos, search);
+	    found = 1;
+	} else
+	    printf("\nNo information available for %s %s\n",
+		   partnames[pos], form);
+    }
+    free(payload);
+    return(found);
+}
+
+#else
+
+static int connectwn(int ac, char *av[])
+{
+    display_message("wn: --connect is not supported on this platform\n");
+    return(-1);
+}
+
+static int remote_search(char *searchword, int pos, int search,
+			 int whichsense, char *label)
+{
+    return(0);
+}
+
+static int remote_is_defined(char *searchword)
+{
+    return(-1);
+}
+
+#endif /* _WIN32 */
+
 static int do_is_defined(char *searchword)
 {
     int i, found = 0;
@@ -251,6 +762,9 @@ static int do_is_defined(char *searchword)
     /* Print all valid searches for word in all parts of speech */
 
     strtolower(strsubst(searchword, ' ', '_'));
+
+    if (serverin != NULL)
+	return(remote_is_defined(searchword));
 	    
     for (i = 1; i <= NUMPARTS; i++) {
 	if ((search = is_defined(searchword, i)) != 0) {
@@ -288,13 +802,26 @@ static void printsearches(char *word, int dbase, unsigned long search)
 	}
 }
 
+static void printstats(char *what, WNStats *st)
+{
+    printf("\nLibrary statistics for %s\n", what);
+    printf("\tbin_search calls %lu, probes %lu, bytes read %lu\n",
+	   st->binsearches, st->probes, st->bytesread);
+    printf("\tindex entries parsed %lu, synsets parsed %lu\n",
+	   st->indexparsed, st->synsetsparsed);
+    printf("\tcache hits %lu, misses %lu, allocations %lu\n",
+	   st->cachehits, st->cachemisses, st->allocs);
+}
+
 static void printusage()
 {
     int i;
 
     fprintf(stdout,
 	    "\nusage: wn word [-hgla] [-n#] -searchtype [-searchtype...]\n");
-    fprintf(stdout, "       wn [-l]\n\n");
+    fprintf(stdout, "       wn [-l]\n");
+    fprintf(stdout, "       wn --batch [-j#] < requests\n");
+    fprintf(stdout, "       wn --connect socket word [-hgla] [-n#] -searchtype [-searchtype...]\n\n");
     fprintf(stdout, "\t-h\t\tDisplay help text before search output\n");
     fprintf(stdout, "\t-g\t\tDisplay gloss\n");
     fprintf(stdout, "\t-l\t\tDisplay license and copyright notice\n");
@@ -302,6 +829,8 @@ static void printusage()
     fprintf(stdout, "\t-o\t\tDisplay synset offset\n");
     fprintf(stdout, "\t-s\t\tDisplay sense numbers in synsets\n");
     fprintf(stdout, "\t-n#\t\tSearch only sense number #\n");
+    fprintf(stdout, "\t-stats\t\tDisplay library statistics for each search\n");
+    fprintf(stdout, "\t-j#\t\tUse # worker processes with --batch\n");
     fprintf(stdout,"\nsearchtype is at least one of the following:\n");
 
     for (i = 1; i <= OVERVIEW; i++)
@@ -324,6 +853,7 @@ static int cmdopt(char *str)
 	!strcmp("-l", str) ||
 	!strcmp("-a", str) ||
 	!strcmp("-s", str) ||
+	!strcmp("-stats", str) ||
 	(!strncmp("-n", str, 2) && strncmp("-nomn", str,5)))
 
 	return (1);
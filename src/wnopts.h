@@ -0,0 +1,88 @@
+/*
+
+  wnopts.h - search options of the wn command
+
+  Both wn and wn-bench include this, so the benchmarks and the -gate
+  regression check in wn-bench always cover every search wn offers.
+
+*/
+
+#ifndef _WNOPTS_
+#define _WNOPTS_
+
+#define OPTALIAS	1	/* old name for a search another option does */
+
+struct wnoption {
+    char *option;		/* user's search request */
+    int search;			/* search to pass findtheinfo() */
+    int pos;			/* part-of-speech to pass findtheinfo() */
+    int helpmsgidx;		/* index into help message table */
+    char *label;		/* text for search header message */
+    int flags;			/* OPTALIAS */
+};
+
+static struct wnoption optlist[] = {
+    { "-synsa", SIMPTR,	ADJ, 0, "Similarity", 0 },
+    { "-antsa", ANTPTR,	ADJ, 1, "Antonyms", 0 },
+    { "-perta", PERTPTR, ADJ, 0, "Pertainyms", 0 },
+    { "-attra", ATTRIBUTE, ADJ, 2, "Attributes", 0 },
+    { "-domna", CLASSIFICATION, ADJ, 3, "Domain", 0 },
+    { "-domta", CLASS, ADJ, 4, "Domain Terms", 0 },
+    { "-famla", FREQ, ADJ, 5, "Familiarity", 0 },
+    { "-grepa", WNGREP, ADJ, 6, "Grep", 0 },
+
+    { "-synsn", HYPERPTR, NOUN, 0, "Synonyms/Hypernyms (Ordered by Estimated Frequency)", 0 },
+    { "-antsn", ANTPTR,	NOUN, 2, "Antonyms", 0 },
+    { "-coorn", COORDS, NOUN, 3, "Coordinate Terms (sisters)", 0 },
+    { "-hypen", -HYPERPTR, NOUN, 4, "Synonyms/Hypernyms (Ordered by Estimated Frequency)", 0 },
+    { "-hypon", HYPOPTR, NOUN, 5, "Hyponyms", 0 },
+    { "-treen", -HYPOPTR, NOUN, 6, "Hyponyms", 0 },
+    { "-holon", HOLONYM, NOUN, 7, "Holonyms", 0 },
+    { "-sprtn", ISPARTPTR, NOUN, 7, "Part Holonyms", 0 },
+    { "-smemn", ISMEMBERPTR, NOUN, 7, "Member Holonyms", 0 },
+    { "-ssubn", ISSTUFFPTR, NOUN, 7, "Substance Holonyms", 0 },
+    { "-hholn",	-HHOLONYM, NOUN, 8, "Holonyms", 0 },
+    { "-meron", MERONYM, NOUN, 9, "Meronyms", 0 },
+    { "-subsn", HASSTUFFPTR, NOUN, 9, "Substance Meronyms", 0 },
+    { "-partn", HASPARTPTR, NOUN, 9, "Part Meronyms", 0 },
+    { "-membn", HASMEMBERPTR, NOUN, 9, "Member Meronyms", 0 },
+    { "-hmern", -HMERONYM, NOUN, 10, "Meronyms", 0 },
+    { "-nomnn", DERIVATION, NOUN, 11, "Derived Forms", OPTALIAS },
+    { "-derin", DERIVATION, NOUN, 11, "Derived Forms", 0 },
+    { "-domnn", CLASSIFICATION, NOUN, 13, "Domain", 0 },
+    { "-domtn", CLASS, NOUN, 14, "Domain Terms", 0 },
+    { "-attrn", ATTRIBUTE, NOUN, 12, "Attributes", 0 },
+    { "-famln", FREQ, NOUN, 15, "Familiarity", 0 },
+    { "-grepn", WNGREP, NOUN, 16, "Grep", 0 },
+
+    { "-synsv", HYPERPTR, VERB, 0, "Synonyms/Hypernyms (Ordered by Estimated Frequency)", 0 },
+    { "-simsv", RELATIVES, VERB, 1, "Synonyms (Grouped by Similarity of Meaning)", 0 },
+    { "-antsv", ANTPTR, VERB, 2, "Antonyms", 0 },
+    { "-coorv", COORDS, VERB, 3, "Coordinate Terms (sisters)", 0 },
+    { "-hypev", -HYPERPTR, VERB, 4, "Synonyms/Hypernyms (Ordered by Estimated Frequency)", 0 },
+    { "-hypov", HYPOPTR, VERB, 5, "Troponyms (hyponyms)", 0 },
+    { "-treev", -HYPOPTR, VERB, 5, "Troponyms (hyponyms)", 0 },
+    { "-tropv", -HYPOPTR, VERB, 5, "Troponyms (hyponyms)", OPTALIAS },
+    { "-entav", ENTAILPTR, VERB, 6, "Entailment", 0 },
+    { "-causv", CAUSETO, VERB, 7, "\'Cause To\'", 0 },
+    { "-nomnv", DERIVATION, VERB, 8, "Derived Forms", OPTALIAS },
+    { "-deriv", DERIVATION, VERB, 8, "Derived Forms", 0 },
+    { "-domnv", CLASSIFICATION, VERB, 10, "Domain", 0 },
+    { "-domtv", CLASS, VERB, 11, "Domain Terms", 0 },
+    { "-framv", FRAMES, VERB, 9, "Sample Sentences", 0 },
+    { "-famlv", FREQ, VERB, 12, "Familiarity", 0 },
+    { "-grepv", WNGREP, VERB, 13, "Grep", 0 },
+
+    { "-synsr", SYNS, ADV, 0, "Synonyms", 0 },
+    { "-antsr", ANTPTR, ADV, 1, "Antonyms", 0 },
+    { "-pertr", PERTPTR, ADV, 0, "Pertainyms", 0 },
+    { "-domnr", CLASSIFICATION, ADV, 2, "Domain", 0 },
+    { "-domtr", CLASS, ADV, 3, "Domain Terms", 0 },
+    { "-famlr", FREQ, ADV, 4, "Familiarity", 0 },
+    { "-grepr", WNGREP, ADV, 5, "Grep", 0 },
+
+    { "-over", OVERVIEW, ALL_POS, -1, "Overview", 0 },
+    { NULL, 0, 0, 0, NULL, 0 }
+};
+
+#endif /* _WNOPTS_ */